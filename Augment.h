@@ -0,0 +1,37 @@
+#pragma once
+
+/*
+augmentation policies of rb::RBTree
+
+an augmentation adds data to every node which the tree keeps up to date in insert, remove,
+the rotations, the bulk load and join/split
+    NoAugment      (default) nothing: no extra bytes per node, no extra work per rotation
+    SubtreeSize    number of nodes in the subtree of every node, enables select(k), rank(key)
+                   and countRange(lo, hi) in O(log n)
+
+every policy gives
+    NodeData       extra base class of the node
+    enabled        false when the tree can skip every update
+*/
+
+#include <cstdint>
+
+namespace rb {
+
+struct NoAugment{
+    struct NodeData {};
+    static constexpr bool enabled = false;
+};
+
+//Count limits the number of keys, the default 32 bits often fits into the padding behind the links
+template<class Count = std::uint32_t>
+struct SubtreeSizeOf{
+    struct NodeData{
+        Count subtreeSize = 1;
+    };
+    static constexpr bool enabled = true;
+};
+
+using SubtreeSize = SubtreeSizeOf<>;
+
+}   //namespace rb
@@ -0,0 +1,423 @@
+#pragma once
+
+/*
+rb::ConcurrentRBTree, a red-black tree one thread can update while any number of threads read
+
+    rb::ConcurrentRBTree<Key, Value, Compare, Allocator>
+    rb::ConcurrentRBSet<Key> / rb::ConcurrentRBMap<Key, Value>
+
+readers (contains, find, forEachInRange) never lock:
+  - a seqlock version says if a writer ran while the reader walked the tree, an odd version
+    means a writer is inside. the reader validates at the end and walks again if it changed,
+    after maxOptimisticAttempts failed walks it takes the writer lock once instead
+  - the child links are atomics, so a reader racing with a rotation reads old or new links,
+    never torn ones. such a walk may go wrong, the validation throws it away
+  - remove() does not free the node, it is retired and only freed when every reader which
+    could still be standing on it has finished (epoch based reclamation, see EpochDomain)
+writers (insert, emplace, remove) serialize on one mutex and run the normal RBTree code,
+fixInsert/fixRemove included. a write which changes nothing (duplicate insert, missing key)
+does not bump the version, so it never makes readers retry.
+
+keys and values are never modified after insertion, readers copy them out. no iterators:
+a consistent view needs either the lock or a copy (forEachInRange).
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "RBTree.h"
+
+namespace rb {
+
+//a child link readers may load while the writer stores it, release/acquire so a reader also sees the node's key
+template<class Node>
+class AtomicLink{
+    private:
+        std::atomic<Node*> node_;
+
+    public:
+        AtomicLink(Node* node = nullptr) noexcept : node_(node) {}
+        AtomicLink(const AtomicLink&) = delete;
+
+        AtomicLink& operator=(Node* node) noexcept{
+            node_.store(node, std::memory_order_release);
+            return *this;
+        }
+        operator Node*() const noexcept { return node_.load(std::memory_order_acquire); }
+};
+
+/*
+nodes allocated one by one like PointerStore, but destroy() only retires the node:
+the owner hands it to free() once no reader can reach it any more.
+release() never drops the nodes at once, a reader could still be inside them
+*/
+template<class Node, class Allocator>
+class DeferredStore{
+    public:
+        using Ref = Node*;
+
+    private:
+        PointerStore<Node, Allocator> nodes_;
+        std::vector<Node*> retired_;
+
+    public:
+        explicit DeferredStore(const Allocator& alloc) : nodes_(alloc) {}
+        DeferredStore(DeferredStore&& other) noexcept : nodes_(std::move(other.nodes_)), retired_(std::move(other.retired_)) {}
+        ~DeferredStore(){
+            for(Node* node : retired_) nodes_.destroy(node);
+        }
+
+        Node& get(Ref ref) const { return *ref; }
+
+        template<class... Args>
+        Ref create(Args&&... args) { return nodes_.create(std::forward<Args>(args)...); }
+
+        void destroy(Ref ref) { retired_.push_back(ref); }
+        void reserve(std::size_t) {}
+        bool release() { return false; }
+        Allocator get_allocator() const { return nodes_.get_allocator(); }
+
+        //nodes retired since the last call, the caller frees them later
+        std::vector<Node*> takeRetired() { return std::exchange(retired_, {}); }
+        void free(Node* node) { nodes_.destroy(node); }
+};
+
+//PackedPointerLayout with atomic child links, readers only follow left and right
+struct ConcurrentLayout{
+    template<class Node>
+    struct Links{
+        using Ref = Node*;
+
+        AtomicLink<Node> left = nullptr;
+        AtomicLink<Node> right = nullptr;
+        std::uintptr_t parentColor_ = RED;      //only the writer reads it
+
+        Node* parent() const { return reinterpret_cast<Node*>(parentColor_ & ~std::uintptr_t(1)); }
+        void setParent(Node* node) { parentColor_ = reinterpret_cast<std::uintptr_t>(node) | (parentColor_ & 1); }
+        Color color() const { return static_cast<Color>(parentColor_ & 1); }
+        void setColor(Color color) { parentColor_ = (parentColor_ & ~std::uintptr_t(1)) | color; }
+    };
+
+    template<class Node, class Allocator>
+    using Store = DeferredStore<Node, Allocator>;
+};
+
+/*
+epoch based reclamation
+a reader pins the current global epoch into a slot for the time of one operation.
+the writer tags every retired node with the epoch at retirement, and may advance the global epoch
+only when every pinned slot shows the current one. a node retired at epoch e is unreachable for
+every reader pinned later, so once the global epoch reaches e + 2 no pinned reader can hold it.
+slots are claimed by a CAS starting at a per-thread hint, so readers of different threads write
+to different cache lines and need no registration
+*/
+class EpochDomain{
+    public:
+        static constexpr std::size_t slotCount = 128;
+
+    private:
+        struct alignas(64) Slot{
+            std::atomic<std::uint64_t> epoch{0};        //0: free
+        };
+
+        Slot slots_[slotCount];
+        std::atomic<std::uint64_t> globalEpoch_{1};
+
+    public:
+        class Guard{
+            private:
+                Slot* slot_;
+
+            public:
+                explicit Guard(Slot* slot) : slot_(slot) {}
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+                ~Guard(){ slot_->epoch.store(0, std::memory_order_release); }
+        };
+
+        //announce the current epoch before touching any node
+        Guard pin(){
+            static thread_local const std::size_t hint = std::hash<std::thread::id>()(std::this_thread::get_id());
+            for(std::size_t i = 0; ; i++){
+                Slot& slot = slots_[(hint + i) % slotCount];
+                std::uint64_t expected = 0;
+                if(slot.epoch.compare_exchange_strong(expected, globalEpoch_.load(std::memory_order_relaxed))){
+                    //the announcement has to be visible before the first link is loaded
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    return Guard(&slot);
+                }
+                //more readers than slots, wait for one to leave
+                if(i % slotCount == slotCount - 1) std::this_thread::yield();
+            }
+        }
+
+        std::uint64_t epoch() const { return globalEpoch_.load(std::memory_order_relaxed); }
+
+        //writer only: advance when no reader is pinned to an older epoch
+        std::uint64_t tryAdvance(){
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::uint64_t current = globalEpoch_.load(std::memory_order_relaxed);
+            for(const Slot& slot : slots_){
+                std::uint64_t pinned = slot.epoch.load(std::memory_order_acquire);
+                if(pinned && pinned != current) return current;
+            }
+            globalEpoch_.store(current + 1, std::memory_order_release);
+            return current + 1;
+        }
+};
+
+template<class Key, class Value = Empty, class Compare = std::less<Key>, class Allocator = NodePool<Key>>
+class ConcurrentRBTree{
+    public:
+        using Tree = RBTree<Key, Value, Compare, Allocator, ConcurrentLayout>;
+        using Node = typename Tree::Node;
+        using size_type = std::size_t;
+        static constexpr bool isSet = Tree::isSet;
+
+        //optimistic walks before a reader gives up and takes the writer lock
+        static constexpr int maxOptimisticAttempts = 8;
+        //retired nodes collected before the writer tries to advance the epoch and free them
+        static constexpr std::size_t reclaimBatch = 256;
+
+    private:
+        struct Retired{
+            Node* node;
+            std::uint64_t epoch;
+        };
+
+        Tree tree_;
+        std::atomic<Node*> root_;                   //copy of tree_.root_ for the readers
+        std::atomic<std::uint64_t> version_;        //odd while a writer changes the tree
+        std::atomic<size_type> size_;
+        mutable std::mutex writeMutex_;
+        mutable EpochDomain epochs_;
+        std::vector<Retired> limbo_;                //retired nodes in epoch order, writer only
+
+        //writer side of the seqlock, called with writeMutex_ held
+        void beginWrite(){
+            version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        void endWrite(){
+            root_.store(tree_.root_, std::memory_order_release);
+            size_.store(tree_.size_, std::memory_order_relaxed);
+            version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            collectRetired();
+        }
+        void collectRetired();
+
+        /*
+        run walk(root) without the lock until the version is the same before and after,
+        walk returns false when it noticed it went wrong (too deep, keys out of order)
+        falls back to the lock after maxOptimisticAttempts
+        */
+        template<class Walk>
+        void read(Walk&& walk) const;
+
+        Node* findNode(Node* node, const Key& key) const;
+
+    public:
+        ConcurrentRBTree() : ConcurrentRBTree(Compare()) {}
+        explicit ConcurrentRBTree(const Compare& comp, const Allocator& alloc = Allocator())
+        : tree_(comp, alloc), root_(nullptr), version_(0), size_(0) {}
+        ConcurrentRBTree(const ConcurrentRBTree&) = delete;
+        ConcurrentRBTree& operator=(const ConcurrentRBTree&) = delete;
+        //no reader may be inside any more
+        ~ConcurrentRBTree();
+
+        //writers, serialized; return false on duplicated / missing key
+        bool insert(const Key& key) { return emplace(key); }
+        template<class... Args>
+        bool emplace(const Key& key, Args&&... args);
+        bool remove(const Key& oldKey);
+
+        //readers, lock free
+        bool contains(const Key& key) const;
+        std::optional<Value> find(const Key& key) const requires (!isSet);
+
+        //calls fn(key) / fn(key, value) for every key in [lo, hi], all from one consistent version of the tree
+        template<class Function>
+        void forEachInRange(const Key& lo, const Key& hi, Function&& fn) const;
+
+        size_type size() const { return size_.load(std::memory_order_relaxed); }
+        bool empty() const { return size() == 0; }
+
+        //takes the writer lock
+        bool isValidRBTree() const;
+};
+
+template<class Key, class Compare = std::less<Key>, class Allocator = NodePool<Key>>
+using ConcurrentRBSet = ConcurrentRBTree<Key, Empty, Compare, Allocator>;
+
+template<class Key, class Value, class Compare = std::less<Key>, class Allocator = NodePool<Key>>
+using ConcurrentRBMap = ConcurrentRBTree<Key, Value, Compare, Allocator>;
+
+#define RB_CONCURRENT_TEMPLATE template<class Key, class Value, class Compare, class Allocator>
+#define RB_CONCURRENT_TREE ConcurrentRBTree<Key, Value, Compare, Allocator>
+
+RB_CONCURRENT_TEMPLATE
+RB_CONCURRENT_TREE::~ConcurrentRBTree(){
+    for(const Retired& retired : limbo_) tree_.store_.free(retired.node);
+}
+
+//tag what the last write retired, and free what no reader can reach any more
+RB_CONCURRENT_TEMPLATE
+void RB_CONCURRENT_TREE::collectRetired(){
+    std::uint64_t epoch = epochs_.epoch();
+    for(Node* node : tree_.store_.takeRetired()) limbo_.push_back({ node, epoch });
+    if(limbo_.size() < reclaimBatch) return;
+
+    epoch = epochs_.tryAdvance();
+    std::size_t freed = 0;
+    while(freed < limbo_.size() && limbo_[freed].epoch + 2 <= epoch){
+        tree_.store_.free(limbo_[freed].node);
+        freed++;
+    }
+    limbo_.erase(limbo_.begin(), limbo_.begin() + freed);
+}
+
+RB_CONCURRENT_TEMPLATE
+template<class... Args>
+bool RB_CONCURRENT_TREE::emplace(const Key& key, Args&&... args){
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if(tree_.findNode(key)) return false;
+
+    beginWrite();
+    tree_.emplace(key, std::forward<Args>(args)...);
+    endWrite();
+    return true;
+}
+
+RB_CONCURRENT_TEMPLATE
+bool RB_CONCURRENT_TREE::remove(const Key& oldKey){
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if(!tree_.findNode(oldKey)) return false;
+
+    beginWrite();
+    tree_.remove(oldKey);
+    endWrite();
+    return true;
+}
+
+RB_CONCURRENT_TEMPLATE
+template<class Walk>
+void RB_CONCURRENT_TREE::read(Walk&& walk) const{
+    EpochDomain::Guard guard = epochs_.pin();
+
+    for(int attempt = 0; attempt < maxOptimisticAttempts; attempt++){
+        std::uint64_t before = version_.load(std::memory_order_acquire);
+        if(before & 1) continue;        //a writer is inside
+
+        bool walked = walk(root_.load(std::memory_order_acquire));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(walked && version_.load(std::memory_order_relaxed) == before) return;
+    }
+
+    //too much write traffic, read under the lock, nothing can change the tree then
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    walk(tree_.root_);
+}
+
+//a walk deeper than any valid tree raced with a writer, the version check will throw its result away
+RB_CONCURRENT_TEMPLATE
+auto RB_CONCURRENT_TREE::findNode(Node* node, const Key& key) const -> Node*{
+    for(int depth = 0; node && depth < maxTreeDepth; depth++){
+        if(tree_.comp_(node->key, key)) node = node->right;
+        else if(tree_.comp_(key, node->key)) node = node->left;
+        else return node;
+    }
+    return nullptr;
+}
+
+RB_CONCURRENT_TEMPLATE
+bool RB_CONCURRENT_TREE::contains(const Key& key) const{
+    bool found = false;
+    read([&](Node* root){
+        found = findNode(root, key) != nullptr;
+        return true;
+    });
+    return found;
+}
+
+RB_CONCURRENT_TEMPLATE
+std::optional<Value> RB_CONCURRENT_TREE::find(const Key& key) const requires (!isSet){
+    std::optional<Value> value;
+    read([&](Node* root){
+        Node* node = findNode(root, key);
+        if(node) value.emplace(node->value);
+        else value.reset();
+        return true;
+    });
+    return value;
+}
+
+/*
+the keys are copied out first and fn only sees them once the copy is validated,
+a walk racing with a rotation could otherwise hand out missing or repeated keys
+*/
+RB_CONCURRENT_TEMPLATE
+template<class Function>
+void RB_CONCURRENT_TREE::forEachInRange(const Key& lo, const Key& hi, Function&& fn) const{
+    const Compare& comp = tree_.comp_;
+    if(comp(hi, lo)) return;
+
+    using Item = std::conditional_t<isSet, Key, std::pair<Key, Value>>;
+    std::vector<Item> items;
+
+    read([&](Node* node){
+        items.clear();
+        Node* stack[maxTreeDepth];
+        int top = 0;
+
+        while(node){
+            if(comp(node->key, lo)) node = node->right;
+            else{
+                if(top == maxTreeDepth) return false;
+                stack[top++] = node;
+                node = node->left;
+            }
+        }
+
+        const Key* previous = nullptr;
+        while(top > 0){
+            node = stack[--top];
+            if(comp(hi, node->key)) break;
+            //a valid walk is strictly increasing, this also stops a walk caught in a cycle of stale links
+            if(previous && !comp(*previous, node->key)) return false;
+            previous = &node->key;
+
+            if constexpr (isSet) items.push_back(node->key);
+            else items.emplace_back(node->key, node->value);
+
+            for(node = node->right; node; node = node->left){
+                if(top == maxTreeDepth) return false;
+                stack[top++] = node;
+            }
+        }
+        return true;
+    });
+
+    for(const Item& item : items){
+        if constexpr (isSet) fn(item);
+        else fn(item.first, item.second);
+    }
+}
+
+RB_CONCURRENT_TEMPLATE
+bool RB_CONCURRENT_TREE::isValidRBTree() const{
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    return tree_.isValidRBTree();
+}
+
+#undef RB_CONCURRENT_TEMPLATE
+#undef RB_CONCURRENT_TREE
+
+}   //namespace rb
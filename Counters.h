@@ -0,0 +1,50 @@
+#pragma once
+
+/*
+opt-in hot-path counters of the balancing code
+
+    rb::HotPathCounters     what fixInsert / fixRemove did, per thread
+    rb::hotPathCounters()   the counters of the calling thread, reset with = {}
+    RB_COUNT(field)         bumps one counter
+
+compiled in only when RB_COUNTERS is defined to 1 (the CMake option of the same name, or the
+CounterReport target), otherwise RB_COUNT() expands to nothing and the trees pay nothing.
+rb::RBTree and the two original trees (RBTreeImplement.h, RBTreeAI.h) are instrumented, the case
+numbers are the ones in the comments of rb::RBTree::fixInsert / fixRemove.
+the tree height is not a counter, every tree has an O(n) height() for the reports.
+*/
+
+#include <cstdint>
+
+namespace rb {
+
+struct HotPathCounters{
+    std::uint64_t inserts = 0;              //inserts which created a node
+    std::uint64_t removes = 0;              //removes which destroyed a node
+    std::uint64_t insertRotations = 0;
+    std::uint64_t removeRotations = 0;
+    std::uint64_t insertFixupLoops = 0;     //iterations of the fixInsert loop
+    std::uint64_t removeFixupLoops = 0;     //iterations of the fixRemove loop
+
+    std::uint64_t insertCase1 = 0;          //uncle red, recolor and go up
+    std::uint64_t insertCase2 = 0;          //uncle black, inner grandchild, rotate to case 3
+    std::uint64_t insertCase3 = 0;          //uncle black, outer grandchild, recolor and rotate
+
+    std::uint64_t removeCase1 = 0;          //sibling red, recolor and rotate
+    std::uint64_t removeCase2 = 0;          //sibling and its children black, recolor and go up
+    std::uint64_t removeCase3 = 0;          //sibling's far child black, rotate to case 4
+    std::uint64_t removeCase4 = 0;          //sibling's far child red, recolor, rotate and stop
+};
+
+inline HotPathCounters& hotPathCounters(){
+    static thread_local HotPathCounters counters;
+    return counters;
+}
+
+}   //namespace rb
+
+#if defined(RB_COUNTERS) && RB_COUNTERS
+#define RB_COUNT(field) (++::rb::hotPathCounters().field)
+#else
+#define RB_COUNT(field) ((void)0)
+#endif
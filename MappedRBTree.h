@@ -0,0 +1,290 @@
+#pragma once
+
+/*
+rb::MappedRBTree, read-only lookups straight from a file written by rb::RBTree::save()
+
+    rb::MappedRBTree<Key, Value, Compare>
+    rb::MappedRBSet<Key> / rb::MappedRBMap<Key, Value>
+
+the file is mapped into memory and searched as it is: a record's child links are record indices,
+so there is nothing to deserialize and nothing to allocate, the operating system pages in the
+nodes a lookup touches. opening costs the header check plus, when verifyChecksum is true, one
+pass over the records for the checksum; pass false to serve queries right after mmap.
+every link is bounds-checked while walking, a damaged unverified file throws std::runtime_error
+instead of reading outside the mapping.
+Key, Value and Compare have to match the saving tree (sizes and byte order are checked).
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "RBTree.h"
+#include "TreeFile.h"
+
+//without NOMINMAX windows.h defines min and max macros, which break every std::min / std::max after it
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rb {
+
+//a whole file mapped read-only, unmapped by the destructor
+class FileMapping{
+    private:
+        const unsigned char* data_ = nullptr;
+        std::size_t size_ = 0;
+
+        void unmap(){
+            if(!data_) return;
+#if defined(_WIN32)
+            UnmapViewOfFile(data_);
+#else
+            munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+            data_ = nullptr;
+            size_ = 0;
+        }
+
+    public:
+        FileMapping() = default;
+
+        explicit FileMapping(const std::string& path){
+#if defined(_WIN32)
+            HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if(file == INVALID_HANDLE_VALUE) throw std::runtime_error("rb::FileMapping: cannot open " + path);
+            LARGE_INTEGER size;
+            if(!GetFileSizeEx(file, &size) || size.QuadPart == 0){
+                CloseHandle(file);
+                throw std::runtime_error("rb::FileMapping: cannot map empty file " + path);
+            }
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if(mapping) CloseHandle(mapping);       //the view keeps the mapping alive
+            CloseHandle(file);
+            if(!view) throw std::runtime_error("rb::FileMapping: cannot map " + path);
+            data_ = static_cast<const unsigned char*>(view);
+            size_ = static_cast<std::size_t>(size.QuadPart);
+#else
+            int file = ::open(path.c_str(), O_RDONLY);
+            if(file < 0) throw std::runtime_error("rb::FileMapping: cannot open " + path);
+            struct stat status;
+            if(::fstat(file, &status) != 0 || status.st_size == 0){
+                ::close(file);
+                throw std::runtime_error("rb::FileMapping: cannot map empty file " + path);
+            }
+            void* view = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            ::close(file);      //the mapping stays valid without the descriptor
+            if(view == MAP_FAILED) throw std::runtime_error("rb::FileMapping: cannot map " + path);
+            data_ = static_cast<const unsigned char*>(view);
+            size_ = static_cast<std::size_t>(status.st_size);
+#endif
+        }
+
+        FileMapping(FileMapping&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+        FileMapping& operator=(FileMapping&& other) noexcept{
+            if(this != &other){
+                unmap();
+                data_ = std::exchange(other.data_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+            }
+            return *this;
+        }
+        FileMapping(const FileMapping&) = delete;
+        FileMapping& operator=(const FileMapping&) = delete;
+        ~FileMapping(){ unmap(); }
+
+        const unsigned char* data() const { return data_; }
+        std::size_t size() const { return size_; }
+};
+
+template<class Key, class Value = Empty, class Compare = std::less<Key>>
+class MappedRBTree{
+    public:
+        using Record = FileRecord<Key, Value>;
+        using size_type = std::size_t;
+        static constexpr bool isSet = std::is_same_v<Value, Empty>;
+
+    private:
+        FileMapping file_;
+        const Record* records_;
+        std::uint64_t count_;
+        std::uint32_t root_;
+        [[no_unique_address]] Compare comp_;
+
+        //record 'index' (1-based), every link goes through here and is checked
+        const Record& recordAt(std::uint32_t index) const{
+            if(index > count_) throw std::runtime_error("rb::MappedRBTree: link out of range, the file is damaged");
+            return records_[index - 1];
+        }
+
+        std::uint32_t findIndex(const Key& key) const;
+        int dfsCheck(std::uint32_t index, bool& isViolated) const;
+
+    public:
+        explicit MappedRBTree(const std::string& path, bool verifyChecksum = true, const Compare& comp = Compare());
+
+        size_type size() const { return static_cast<size_type>(count_); }
+        bool empty() const { return count_ == 0; }
+        bool contains(const Key& key) const { return findIndex(key) != 0; }
+
+        //the value of key inside the mapping, or nullptr
+        const Value* find(const Key& key) const requires (!isSet){
+            std::uint32_t index = findIndex(key);
+            return index ? &recordAt(index).value : nullptr;
+        }
+
+        //the same scans as rb::RBTree: fn(key) for sets, fn(key, value) for maps
+        template<class Function>
+        void forEachInRange(const Key& lo, const Key& hi, Function&& fn) const;
+        template<class Function>
+        void forEach(Function&& fn) const;
+
+        //one pass over the records: checksum, shape, key order and the red-black rules
+        bool verify() const;
+        bool isValidRBTree() const;
+};
+
+template<class Key, class Compare = std::less<Key>>
+using MappedRBSet = MappedRBTree<Key, Empty, Compare>;
+
+template<class Key, class Value, class Compare = std::less<Key>>
+using MappedRBMap = MappedRBTree<Key, Value, Compare>;
+
+#define RB_MAPPED_TEMPLATE template<class Key, class Value, class Compare>
+#define RB_MAPPED_TREE MappedRBTree<Key, Value, Compare>
+
+RB_MAPPED_TEMPLATE
+RB_MAPPED_TREE::MappedRBTree(const std::string& path, bool verifyChecksum, const Compare& comp)
+: file_(path), records_(nullptr), count_(0), root_(0), comp_(comp) {
+    FileHeader header;
+    if(file_.size() < sizeof(header)) throw std::runtime_error("rb::MappedRBTree: truncated file " + path);
+    std::memcpy(&header, file_.data(), sizeof(header));
+    checkFileHeader<Key, Value>(header, file_.size());
+
+    //mappings are page aligned and recordOffset is a multiple of the record alignment
+    records_ = reinterpret_cast<const Record*>(file_.data() + header.recordOffset);
+    count_ = header.count;
+    root_ = header.root;
+
+    if(verifyChecksum && checksum(records_, count_ * sizeof(Record)) != header.checksum)
+        throw std::runtime_error("rb::MappedRBTree: checksum mismatch in " + path);
+}
+
+RB_MAPPED_TEMPLATE
+std::uint32_t RB_MAPPED_TREE::findIndex(const Key& key) const{
+    std::uint32_t index = root_;
+    //no valid tree is deeper, a deeper walk is a cycle in a damaged file
+    for(int depth = 0; index && depth < maxTreeDepth; depth++){
+        const Record& record = recordAt(index);
+        if(comp_(record.key, key)) index = record.right();
+        else if(comp_(key, record.key)) index = record.left;
+        else return index;
+    }
+    if(index) throw std::runtime_error("rb::MappedRBTree: tree too deep, the file is damaged");
+    return 0;
+}
+
+RB_MAPPED_TEMPLATE
+template<class Function>
+void RB_MAPPED_TREE::forEachInRange(const Key& lo, const Key& hi, Function&& fn) const{
+    if(comp_(hi, lo)) return;
+
+    std::uint32_t stack[maxTreeDepth];
+    int top = 0;
+    auto push = [&](std::uint32_t index){
+        if(top == maxTreeDepth) throw std::runtime_error("rb::MappedRBTree: tree too deep, the file is damaged");
+        stack[top++] = index;
+    };
+
+    std::uint32_t index = root_;
+    while(index){
+        const Record& record = recordAt(index);
+        if(comp_(record.key, lo)) index = record.right();
+        else{
+            push(index);
+            index = record.left;
+        }
+    }
+
+    //a valid walk visits every record at most once, more means a cycle in a damaged file
+    for(std::uint64_t visited = 0; top > 0; visited++){
+        if(visited == count_) throw std::runtime_error("rb::MappedRBTree: cycle in the tree, the file is damaged");
+        const Record& record = recordAt(stack[--top]);
+        if(comp_(hi, record.key)) return;
+
+        if constexpr (isSet) fn(record.key);
+        else fn(record.key, record.value);
+
+        for(index = record.right(); index; index = recordAt(index).left) push(index);
+    }
+}
+
+RB_MAPPED_TEMPLATE
+template<class Function>
+void RB_MAPPED_TREE::forEach(Function&& fn) const{
+    //records are stored in key order, a plain scan is the in-order walk
+    for(std::uint64_t i = 0; i < count_; i++){
+        if constexpr (isSet) fn(records_[i].key);
+        else fn(records_[i].key, records_[i].value);
+    }
+}
+
+RB_MAPPED_TEMPLATE
+bool RB_MAPPED_TREE::verify() const{
+    FileHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    return checksum(records_, count_ * sizeof(Record)) == header.checksum && isValidRBTree();
+}
+
+RB_MAPPED_TEMPLATE
+bool RB_MAPPED_TREE::isValidRBTree() const{
+    if(!checkFileShape(records_, count_, root_)) return false;
+    for(std::uint64_t i = 1; i < count_; i++){
+        if(!comp_(records_[i - 1].key, records_[i].key)) return false;
+    }
+    if(root_ && recordAt(root_).color() != BLACK) return false;
+
+    bool isViolated = false;
+    dfsCheck(root_, isViolated);
+    return !isViolated;
+}
+
+//black height of the subtree, flags red nodes with red children and unequal black heights
+RB_MAPPED_TEMPLATE
+int RB_MAPPED_TREE::dfsCheck(std::uint32_t index, bool& isViolated) const{
+    if(!index || isViolated) return 1;
+
+    const Record& record = recordAt(index);
+    if(record.color() == RED){
+        if(record.left && recordAt(record.left).color() == RED) isViolated = true;
+        if(record.right() && recordAt(record.right()).color() == RED) isViolated = true;
+    }
+
+    int left = dfsCheck(record.left, isViolated);
+    int right = dfsCheck(record.right(), isViolated);
+    if(left != right) isViolated = true;
+    return left + (record.color() == BLACK ? 1 : 0);
+}
+
+#undef RB_MAPPED_TEMPLATE
+#undef RB_MAPPED_TREE
+
+}   //namespace rb
@@ -0,0 +1,330 @@
+#pragma once
+
+/*
+node layouts of rb::RBTree
+
+a layout decides how a node stores its links and its color, and where nodes live
+    PointerLayout        the layout of RBTreeImplement.c++: a Color field and three raw pointers
+    PackedPointerLayout  (default) the color lives in the low bit of the parent pointer
+    IndexLayout          32-bit indices into one contiguous node array, the color lives in the
+                         low bit of the parent index, index 0 is the null node
+    ConcurrentLayout     (ConcurrentRBTree.h) PackedPointerLayout with atomic child links and
+                         deferred node destruction, for lock-free readers
+
+every layout gives
+    Links<Node>          base class of the node: 'left' and 'right' members, parent()/setParent(),
+                         color()/setColor(), and the type Ref used to refer to a node
+    Store<Node, Alloc>   owner of the nodes: get(ref), create(args...), destroy(ref), release(),
+                         sibling()/shares() to tell if nodes can move between two trees as they are
+
+a null Ref is always false in a boolean context, so tree code can keep writing if(node) / !node
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace rb {
+
+//each node in the Red-Black Tree is either RED or BLACK
+enum Color { RED, BLACK };
+
+/*
+the deepest a red-black tree gets: its height is at most 2 log2(n + 1), below 128 for any n < 2^63,
+more nodes than any memory holds. the walks with a fixed-size stack use it as their size, and a
+walk going deeper knows it is following a broken tree
+*/
+inline constexpr int maxTreeDepth = 128;
+
+/*
+nodes allocated one by one through the allocator, a Ref is a plain pointer
+(shared by PointerLayout and PackedPointerLayout)
+*/
+template<class Node, class Allocator>
+class PointerStore{
+    public:
+        using Ref = Node*;
+        using NodeAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+        using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+    private:
+        [[no_unique_address]] NodeAlloc alloc_;
+
+        struct SameAllocator {};
+        PointerStore(const NodeAlloc& alloc, SameAllocator) : alloc_(alloc) {}
+
+        void detach() noexcept{
+            if constexpr (std::is_default_constructible_v<NodeAlloc> && !NodeTraits::is_always_equal::value){
+                try{
+                    alloc_ = NodeAlloc();
+                }
+                catch(...) {}
+            }
+        }
+
+    public:
+        explicit PointerStore(const Allocator& alloc) : alloc_(alloc) {}
+
+        /*
+        moving copies the allocator (NodePool copies share their slabs) and gives the moved-from store
+        a fresh one when the allocator can be default constructed, so the two stores don't keep sharing
+        a pool: the moved-from tree can go to another thread, and release() of the new one still works.
+        if the fresh allocator can't be made, the moved-from store keeps sharing, it stays usable either way
+        */
+        PointerStore(PointerStore&& other) noexcept : alloc_(other.alloc_) { other.detach(); }
+        PointerStore& operator=(PointerStore&& other) noexcept{
+            if(this == &other) return *this;
+            alloc_ = other.alloc_;
+            other.detach();
+            return *this;
+        }
+
+        Node& get(Ref ref) const { return *ref; }
+
+        template<class... Args>
+        Ref create(Args&&... args){
+            Node* node = NodeTraits::allocate(alloc_, 1);
+            try{
+                NodeTraits::construct(alloc_, node, std::forward<Args>(args)...);
+            }
+            catch(...){
+                NodeTraits::deallocate(alloc_, node, 1);
+                throw;
+            }
+            return node;
+        }
+
+        void destroy(Ref ref){
+            NodeTraits::destroy(alloc_, ref);
+            NodeTraits::deallocate(alloc_, ref, 1);
+        }
+
+        //nodes are allocated one by one, nothing to reserve
+        void reserve(std::size_t) {}
+
+        //drop every node at once when the allocator can do so (rb::NodePool), objects are NOT destroyed
+        bool release(){
+            if constexpr (requires(NodeAlloc& a) { { a.release() } -> std::same_as<bool>; }) return alloc_.release();
+            else return false;
+        }
+
+        Allocator get_allocator() const { return Allocator(alloc_); }
+
+        //an empty store allocating from the same memory (NodePool copies share the slabs)
+        PointerStore sibling() const { return PointerStore(alloc_, SameAllocator()); }
+
+        //nodes of two stores can be moved between trees without copying when one can free the other's nodes
+        bool shares(const PointerStore& other) const { return alloc_ == other.alloc_; }
+};
+
+/*
+all nodes in one contiguous array, a Ref is a 32-bit index into it
+freed slots are chained through their 'left' index and reused first.
+the array grows by doubling and moves nodes with memcpy, so keys and values must be trivially copyable
+*/
+template<class Node, class Allocator>
+class IndexStore{
+    public:
+        using Ref = std::uint32_t;
+        using NodeAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+        using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+        //the parent index is shifted left by one to make room for the color
+        static constexpr std::size_t maxNodes = (std::size_t(1) << 31) - 1;
+
+    private:
+        [[no_unique_address]] NodeAlloc alloc_;
+        Node* nodes_;           //slot 0 is never used, index 0 means nullptr
+        Ref capacity_;
+        Ref used_;              //slots [1, used_) have been handed out at least once
+        Ref freeList_;
+
+        //the old array and its capacity, handed back by grow() so the caller decides when to free it
+        struct Retired{
+            Node* nodes;
+            std::size_t capacity;
+        };
+
+        Retired grow(std::size_t wanted){
+            if(wanted > maxNodes + 1) throw std::length_error("rb::IndexStore: more than 2^31 - 1 nodes");
+
+            std::size_t capacity = capacity_ ? capacity_ : 16;
+            while(capacity < wanted) capacity *= 2;
+            if(capacity > maxNodes + 1) capacity = maxNodes + 1;
+
+            Node* nodes = NodeTraits::allocate(alloc_, capacity);
+            if(nodes_) std::memcpy(static_cast<void*>(nodes), static_cast<const void*>(nodes_), sizeof(Node) * used_);
+            Retired retired{ nodes_, capacity_ };
+            nodes_ = nodes;
+            capacity_ = static_cast<Ref>(capacity);
+            return retired;
+        }
+
+        void freeRetired(Retired retired){
+            if(retired.nodes) NodeTraits::deallocate(alloc_, retired.nodes, retired.capacity);
+        }
+
+    public:
+        explicit IndexStore(const Allocator& alloc)
+        : alloc_(alloc), nodes_(nullptr), capacity_(0), used_(1), freeList_(0) {
+            static_assert(std::is_trivially_copyable_v<Node>,
+                          "rb::IndexLayout moves nodes with memcpy, Key and Value must be trivially copyable");
+        }
+
+        IndexStore(IndexStore&& other) noexcept
+        : alloc_(other.alloc_), nodes_(other.nodes_), capacity_(other.capacity_), used_(other.used_), freeList_(other.freeList_) {
+            other.nodes_ = nullptr;
+            other.capacity_ = 0;
+            other.used_ = 1;
+            other.freeList_ = 0;
+        }
+
+        IndexStore& operator=(IndexStore&& other) noexcept{
+            if(this == &other) return *this;
+            release();
+            alloc_ = other.alloc_;
+            nodes_ = other.nodes_;
+            capacity_ = other.capacity_;
+            used_ = other.used_;
+            freeList_ = other.freeList_;
+            other.nodes_ = nullptr;
+            other.capacity_ = 0;
+            other.used_ = 1;
+            other.freeList_ = 0;
+            return *this;
+        }
+
+        ~IndexStore(){ release(); }
+
+        Node& get(Ref ref) const { return nodes_[ref]; }
+
+        /*
+        args may refer into the array itself (m.emplace(k, m.find(j).value())), so when it has to
+        grow the old array is only freed after the new node is constructed from them
+        */
+        template<class... Args>
+        Ref create(Args&&... args){
+            Ref ref;
+            Retired retired{ nullptr, 0 };
+            bool recycled = freeList_ != 0;
+            if(recycled){
+                ref = freeList_;
+                freeList_ = nodes_[ref].left;
+            }
+            else{
+                if(used_ >= capacity_) retired = grow(std::size_t(used_) + 1);
+                ref = used_++;
+            }
+
+            try{
+                ::new (static_cast<void*>(nodes_ + ref)) Node(std::forward<Args>(args)...);
+            }
+            catch(...){
+                //give the slot back, the array may stay grown
+                if(recycled){
+                    nodes_[ref].left = freeList_;
+                    freeList_ = ref;
+                }
+                else used_--;
+                freeRetired(retired);
+                throw;
+            }
+            freeRetired(retired);
+            return ref;
+        }
+
+        //trivially destructible node, just chain the slot into the free list
+        void destroy(Ref ref){
+            nodes_[ref].left = freeList_;
+            freeList_ = ref;
+        }
+
+        //make room for n nodes at once, avoids the doubling copies of a bulk load
+        void reserve(std::size_t n){
+            if(n + 1 > capacity_) freeRetired(grow(n + 1));
+        }
+
+        //the array owns every node, it can always be dropped at once
+        bool release(){
+            if(nodes_) NodeTraits::deallocate(alloc_, nodes_, capacity_);
+            nodes_ = nullptr;
+            capacity_ = 0;
+            used_ = 1;
+            freeList_ = 0;
+            return true;
+        }
+
+        std::size_t capacity() const { return capacity_; }
+        Allocator get_allocator() const { return Allocator(alloc_); }
+
+        //indices only mean something inside their own array, nodes never move between stores
+        IndexStore sibling() const { return IndexStore(get_allocator()); }
+        bool shares(const IndexStore& other) const { return this == &other; }
+};
+
+//the layout of RBTreeImplement.c++, kept as a baseline
+struct PointerLayout{
+    template<class Node>
+    struct Links{
+        using Ref = Node*;
+
+        Node* left = nullptr;
+        Node* right = nullptr;
+        Node* parent_ = nullptr;
+        Color color_ = RED;         //last, so a small key can sit in the padding behind it
+
+        Node* parent() const { return parent_; }
+        void setParent(Node* node) { parent_ = node; }
+        Color color() const { return color_; }
+        void setColor(Color color) { color_ = color; }
+    };
+
+    template<class Node, class Allocator>
+    using Store = PointerStore<Node, Allocator>;
+};
+
+//parent pointer and color share one word, nodes are at least 2-byte aligned so bit 0 is free
+struct PackedPointerLayout{
+    template<class Node>
+    struct Links{
+        using Ref = Node*;
+
+        Node* left = nullptr;
+        Node* right = nullptr;
+        std::uintptr_t parentColor_ = RED;
+
+        Node* parent() const { return reinterpret_cast<Node*>(parentColor_ & ~std::uintptr_t(1)); }
+        void setParent(Node* node) { parentColor_ = reinterpret_cast<std::uintptr_t>(node) | (parentColor_ & 1); }
+        Color color() const { return static_cast<Color>(parentColor_ & 1); }
+        void setColor(Color color) { parentColor_ = (parentColor_ & ~std::uintptr_t(1)) | color; }
+    };
+
+    template<class Node, class Allocator>
+    using Store = PointerStore<Node, Allocator>;
+};
+
+//32-bit links, parent index and color share one word
+struct IndexLayout{
+    template<class Node>
+    struct Links{
+        using Ref = std::uint32_t;
+
+        std::uint32_t left = 0;
+        std::uint32_t right = 0;
+        std::uint32_t parentColor_ = RED;
+
+        std::uint32_t parent() const { return parentColor_ >> 1; }
+        void setParent(std::uint32_t node) { parentColor_ = (node << 1) | (parentColor_ & 1); }
+        Color color() const { return static_cast<Color>(parentColor_ & 1); }
+        void setColor(Color color) { parentColor_ = (parentColor_ & ~std::uint32_t(1)) | color; }
+    };
+
+    template<class Node, class Allocator>
+    using Store = IndexStore<Node, Allocator>;
+};
+
+}   //namespace rb
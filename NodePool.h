@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace rb {
+
+/*
+slab/arena allocator for tree nodes
+
+- memory is carved out of big slabs, so nodes created together also sit together in memory
+- a freed node is pushed to an intrusive free list and recycled by the next allocate(1)
+- release() gives every slab back at once without visiting the nodes (O(number of slabs))
+
+copies of a NodePool share the same slabs, because a copy of an allocator has to be able to
+free what the original allocated. rebound copies (NodePool<U> made from a NodePool<T>) share
+them too: the shared NodePoolState keeps one size class (slabs + free list) per block size,
+so NodePool<T>(NodePool<U>(a)) == a, and trees built with get_allocator() of another tree
+really allocate from the same pool.
+only single objects are pooled, arrays fall back to operator new.
+NOT thread-safe, the same as RBTree itself: trees sharing a pool must stay on one thread.
+*/
+
+//the memory behind every copy and every rebound copy of one NodePool
+template<std::size_t SlabBytes>
+struct NodePoolState{
+    //every freed block stores the next free block in its first bytes
+    struct FreeBlock{
+        FreeBlock* next;
+    };
+
+    //every slab starts with a header linking all slabs of the size class together
+    struct SlabHeader{
+        SlabHeader* next;
+    };
+
+    //the header rounded up to the block alignment, the blocks start right after it
+    static constexpr std::size_t headerSize(std::size_t blockAlign){
+        return (sizeof(SlabHeader) + blockAlign - 1) / blockAlign * blockAlign;
+    }
+    //the blocks one slab holds, a single one when a block doesn't fit SlabBytes
+    static constexpr std::size_t blocksPerSlab(std::size_t blockSize, std::size_t blockAlign){
+        return SlabBytes > headerSize(blockAlign) + blockSize ? (SlabBytes - headerSize(blockAlign)) / blockSize : 1;
+    }
+
+    //the slabs and the free list of one block size
+    struct SizeClass{
+        std::size_t blockSize;
+        std::size_t blockAlign;
+        FreeBlock* freeList = nullptr;
+        SlabHeader* slabs = nullptr;
+        unsigned char* bumpCurrent = nullptr;     //next never used block in the newest slab
+        unsigned char* bumpEnd = nullptr;
+        std::size_t slabCount = 0;
+        std::size_t liveCount = 0;
+
+        SizeClass(std::size_t size, std::size_t align) : blockSize(size), blockAlign(align) {}
+        SizeClass(const SizeClass&) = delete;
+        SizeClass& operator=(const SizeClass&) = delete;
+        ~SizeClass(){ freeSlabs(); }
+
+        //get a fresh slab and make it the bump region
+        void grow(){
+            std::size_t bytes = headerSize(blockAlign) + blocksPerSlab(blockSize, blockAlign) * blockSize;
+            void* memory = ::operator new(bytes, std::align_val_t(blockAlign));
+
+            SlabHeader* slab = static_cast<SlabHeader*>(memory);
+            slab->next = slabs;
+            slabs = slab;
+            slabCount++;
+
+            bumpCurrent = static_cast<unsigned char*>(memory) + headerSize(blockAlign);
+            bumpEnd = static_cast<unsigned char*>(memory) + bytes;
+        }
+
+        void freeSlabs(){
+            while(slabs){
+                SlabHeader* next = slabs->next;
+                ::operator delete(static_cast<void*>(slabs), std::align_val_t(blockAlign));
+                slabs = next;
+            }
+            freeList = nullptr;
+            bumpCurrent = bumpEnd = nullptr;
+            slabCount = 0;
+            liveCount = 0;
+        }
+    };
+
+    //a handful at most, one per node type allocated through the pool
+    std::vector<std::unique_ptr<SizeClass>> classes;
+
+    SizeClass* classFor(std::size_t size, std::size_t align){
+        for(auto& sizeClass : classes){
+            if(sizeClass->blockSize == size && sizeClass->blockAlign == align) return sizeClass.get();
+        }
+        classes.push_back(std::make_unique<SizeClass>(size, align));
+        return classes.back().get();
+    }
+
+    void freeSlabs(){
+        for(auto& sizeClass : classes) sizeClass->freeSlabs();
+    }
+};
+
+template<class T, std::size_t SlabBytes = 64 * 1024>
+class NodePool{
+    private:
+        using State = NodePoolState<SlabBytes>;
+        using FreeBlock = typename State::FreeBlock;
+        using SizeClass = typename State::SizeClass;
+
+        //block size and alignment: a block has to hold either a T or a free list link
+        static constexpr std::size_t blockAlign(){
+            return alignof(T) > alignof(FreeBlock) ? alignof(T) : alignof(FreeBlock);
+        }
+        static constexpr std::size_t blockSize(){
+            std::size_t size = sizeof(T) > sizeof(FreeBlock) ? sizeof(T) : sizeof(FreeBlock);
+            return (size + blockAlign() - 1) / blockAlign() * blockAlign();
+        }
+
+        std::shared_ptr<State> state_;
+        SizeClass* class_;          //the size class of T inside state_
+
+        template<class U, std::size_t B> friend class NodePool;
+
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+        using is_always_equal = std::false_type;
+
+        template<class U> struct rebind{ using other = NodePool<U, SlabBytes>; };
+
+        NodePool() : state_(std::make_shared<State>()), class_(state_->classFor(blockSize(), blockAlign())) {}
+
+        //copies share the slabs, there is no move constructor on purpose: a moved-from pool must stay usable
+        NodePool(const NodePool& other) = default;
+        NodePool& operator=(const NodePool& other) = default;
+
+        //rebinding from another type shares the pool too, blocks sized for T come from their own size class
+        template<class U>
+        NodePool(const NodePool<U, SlabBytes>& other)
+        : state_(other.state_), class_(state_->classFor(blockSize(), blockAlign())) {}
+
+        T* allocate(std::size_t n){
+            if(n != 1) return std::allocator<T>().allocate(n);
+
+            //first reuse freed blocks, then take the next untouched block, then grow
+            SizeClass& state = *class_;
+            void* block;
+            if(state.freeList){
+                block = state.freeList;
+                state.freeList = state.freeList->next;
+            }
+            else{
+                if(state.bumpCurrent == state.bumpEnd) state.grow();
+                block = state.bumpCurrent;
+                state.bumpCurrent += blockSize();
+            }
+            state.liveCount++;
+            return static_cast<T*>(block);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept{
+            if(n != 1){
+                std::allocator<T>().deallocate(p, n);
+                return;
+            }
+
+            SizeClass& state = *class_;
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(p);
+            block->next = state.freeList;
+            state.freeList = block;
+            state.liveCount--;
+        }
+
+        /*
+        give every slab back at once, the objects inside are NOT destroyed
+        only possible when no other copy of the pool can still reach the slabs,
+        returns false (and does nothing) otherwise
+        */
+        bool release() noexcept{
+            if(state_.use_count() != 1) return false;
+            state_->freeSlabs();
+            return true;
+        }
+
+        //statistics of the blocks sized for T, mainly for benchmarks
+        std::size_t slabCount() const { return class_->slabCount; }
+        std::size_t liveCount() const { return class_->liveCount; }
+        static constexpr std::size_t nodesPerSlab() { return State::blocksPerSlab(blockSize(), blockAlign()); }
+
+        //two pools are equal when they share the slabs, rebound copies included
+        template<class U>
+        bool operator==(const NodePool<U, SlabBytes>& other) const { return state_ == other.state_; }
+        template<class U>
+        bool operator!=(const NodePool<U, SlabBytes>& other) const { return !(*this == other); }
+};
+
+}   //namespace rb
@@ -0,0 +1,538 @@
+#pragma once
+
+/*
+rb::PersistentRBTree, a red-black tree with O(1) snapshots
+
+    rb::PersistentRBTree<Key, Value, Compare, Allocator>
+    rb::PersistentRBSet<Key> / rb::PersistentRBMap<Key, Value>
+
+snapshot() hands out an immutable Snapshot of the current content in O(1): it only takes a
+reference on the root. the tree and all its snapshots share every node they have in common.
+insert/remove copy a node only when it is shared (path copying): a node referenced once belongs to
+the live tree alone and is changed in place, so without snapshots nothing is ever copied, and after
+a snapshot the next updates copy the O(log n) nodes on their path plus the few siblings the
+rebalancing recolors or rotates.
+memory is reclaimed by reference counting: every node counts the parents (and roots) pointing at
+it, the last Snapshot or tree version dropping a node frees it and releases its children.
+
+shared nodes can have many parents, so there are no parent links: insert and remove record the
+search path and fixInsert/fixRemove climb that path instead. they only touch nodes they own,
+a shared sibling is copied (own()) before its color changes or it takes part in a rotation.
+
+the counts are atomic, snapshots may be read and dropped on other threads while one thread
+updates the tree. the Allocator then has to be thread-safe (the default std::allocator is,
+rb::NodePool is not). keys and values are copied when a shared node is copied.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "NodeLayout.h"
+#include "RBTree.h"
+
+namespace rb {
+
+template<class Key, class Value>
+struct PersistentNode{
+    std::atomic<std::uint32_t> refs{1};     //parents and roots pointing at this node
+    Color color = RED;
+    PersistentNode* left = nullptr;
+    PersistentNode* right = nullptr;
+    Key key;
+    [[no_unique_address]] Value value;
+
+    template<class K, class... Args>
+    explicit PersistentNode(K&& newKey, Args&&... args)
+    : key(std::forward<K>(newKey)), value(std::forward<Args>(args)...) {}
+};
+
+/*
+one version of the tree: a counted reference on a root
+the read-only half shared by the live tree and its snapshots
+*/
+template<class Key, class Value, class Compare, class Allocator>
+class PersistentVersion{
+    public:
+        using Node = PersistentNode<Key, Value>;
+        using size_type = std::size_t;
+        static constexpr bool isSet = std::is_same_v<Value, Empty>;
+
+    protected:
+        using NodeAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+        using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+        Node* root_;
+        size_type size_;
+        [[no_unique_address]] Compare comp_;
+        [[no_unique_address]] NodeAlloc alloc_;
+
+        PersistentVersion(Node* root, size_type size, const Compare& comp, const NodeAlloc& alloc)
+        : root_(root), size_(size), comp_(comp), alloc_(alloc) {}
+
+        static void ref(Node* node){
+            if(node) node->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        //drop one reference, free what nobody references any more (without recursion)
+        void unref(Node* node);
+
+        Node* findNode(const Key& key) const;
+        int dfsCheck(const Node* node, bool& isViolated, size_type& count) const;
+
+    public:
+        PersistentVersion(const PersistentVersion& other)
+        : root_(other.root_), size_(other.size_), comp_(other.comp_), alloc_(other.alloc_) { ref(root_); }
+        PersistentVersion(PersistentVersion&& other) noexcept
+        : root_(std::exchange(other.root_, nullptr)), size_(std::exchange(other.size_, 0)),
+          comp_(other.comp_), alloc_(other.alloc_) {}
+        PersistentVersion& operator=(PersistentVersion other) noexcept{
+            std::swap(root_, other.root_);
+            std::swap(size_, other.size_);
+            std::swap(comp_, other.comp_);
+            std::swap(alloc_, other.alloc_);
+            return *this;
+        }
+        ~PersistentVersion(){ unref(root_); }
+
+        size_type size() const { return size_; }
+        bool empty() const { return !root_; }
+        bool contains(const Key& key) const { return findNode(key) != nullptr; }
+
+        //the value of key, or nullptr. stays valid as long as this version does
+        const Value* find(const Key& key) const requires (!isSet){
+            const Node* node = findNode(key);
+            return node ? &node->value : nullptr;
+        }
+
+        //in key order, fn(key) for sets, fn(key, value) for maps
+        template<class Function>
+        void forEach(Function&& fn) const;
+
+        bool isValidRBTree() const;
+};
+
+template<class Key, class Value = Empty, class Compare = std::less<Key>, class Allocator = std::allocator<Key>>
+class PersistentRBTree : public PersistentVersion<Key, Value, Compare, Allocator>{
+    private:
+        using Base = PersistentVersion<Key, Value, Compare, Allocator>;
+        using typename Base::NodeAlloc;
+        using typename Base::NodeTraits;
+        using Base::root_;
+        using Base::size_;
+        using Base::comp_;
+        using Base::alloc_;
+        using Base::ref;
+        using Base::unref;
+
+    public:
+        using Node = typename Base::Node;
+        using size_type = typename Base::size_type;
+
+        //an immutable version of the tree, cheap to copy, independent of the tree's later updates
+        class Snapshot : public Base{
+            private:
+                friend class PersistentRBTree;
+                using Base::Base;
+        };
+
+    private:
+        template<class... Args>
+        Node* create(Args&&... args);
+
+        //the node itself when only this tree references it, otherwise a private copy of it
+        Node* own(Node* node);
+
+        //the link in the path which points at path[depth]
+        Node*& linkTo(Node** path, int depth);
+
+        //rotate the subtree hanging at link, both nodes moving must be owned; returns the new subtree root
+        Node* leftRotation(Node*& link);
+        Node* rightRotation(Node*& link);
+
+        void fixInsert(Node** path, int depth);
+        void fixRemove(Node** path, int parentDepth, Node** xLink);
+
+    public:
+        PersistentRBTree() : PersistentRBTree(Compare()) {}
+        explicit PersistentRBTree(const Compare& comp, const Allocator& alloc = Allocator())
+        : Base(nullptr, 0, comp, NodeAlloc(alloc)) {}
+
+        //O(1), the snapshot shares every node with the tree
+        Snapshot snapshot() const{
+            ref(root_);
+            return Snapshot(root_, size_, comp_, alloc_);
+        }
+
+        //insert, emplace, remove interface; return false on duplicated / missing key
+        bool insert(const Key& key) { return emplace(key); }
+        template<class... Args>
+        bool emplace(const Key& key, Args&&... args);
+        bool remove(const Key& oldKey);
+
+        void clear(){
+            unref(root_);
+            root_ = nullptr;
+            size_ = 0;
+        }
+};
+
+template<class Key, class Compare = std::less<Key>, class Allocator = std::allocator<Key>>
+using PersistentRBSet = PersistentRBTree<Key, Empty, Compare, Allocator>;
+
+template<class Key, class Value, class Compare = std::less<Key>, class Allocator = std::allocator<Key>>
+using PersistentRBMap = PersistentRBTree<Key, Value, Compare, Allocator>;
+
+#define RB_VERSION_TEMPLATE template<class Key, class Value, class Compare, class Allocator>
+#define RB_VERSION PersistentVersion<Key, Value, Compare, Allocator>
+#define RB_PERSISTENT PersistentRBTree<Key, Value, Compare, Allocator>
+
+RB_VERSION_TEMPLATE
+void RB_VERSION::unref(Node* node){
+    std::vector<Node*> dead;
+    while(true){
+        //the last reference: whoever drops it frees the node
+        if(node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1){
+            if(node->left) dead.push_back(node->left);
+            if(node->right) dead.push_back(node->right);
+            NodeTraits::destroy(alloc_, node);
+            NodeTraits::deallocate(alloc_, node, 1);
+        }
+        if(dead.empty()) return;
+        node = dead.back();
+        dead.pop_back();
+    }
+}
+
+RB_VERSION_TEMPLATE
+auto RB_VERSION::findNode(const Key& key) const -> Node*{
+    Node* node = root_;
+    while(node){
+        if(comp_(node->key, key)) node = node->right;
+        else if(comp_(key, node->key)) node = node->left;
+        else break;
+    }
+    return node;
+}
+
+RB_VERSION_TEMPLATE
+template<class Function>
+void RB_VERSION::forEach(Function&& fn) const{
+    const Node* stack[maxTreeDepth];
+    int top = 0;
+    for(const Node* node = root_; node || top > 0; ){
+        while(node){
+            stack[top++] = node;
+            node = node->left;
+        }
+        node = stack[--top];
+        if constexpr (isSet) fn(node->key);
+        else fn(node->key, node->value);
+        node = node->right;
+    }
+}
+
+RB_VERSION_TEMPLATE
+bool RB_VERSION::isValidRBTree() const{
+    if(!root_) return size_ == 0;
+    if(root_->color != BLACK) return false;
+
+    bool isViolated = false;
+    size_type count = 0;
+    dfsCheck(root_, isViolated, count);
+    return !isViolated && count == size_;
+}
+
+//black height of the subtree, checks the colors and the key order on the way, counts the nodes
+RB_VERSION_TEMPLATE
+int RB_VERSION::dfsCheck(const Node* node, bool& isViolated, size_type& count) const{
+    if(!node || isViolated) return 1;
+    count++;
+
+    if(node->color == RED && ((node->left && node->left->color == RED) || (node->right && node->right->color == RED))) isViolated = true;
+    if(node->left && !comp_(node->left->key, node->key)) isViolated = true;
+    if(node->right && !comp_(node->key, node->right->key)) isViolated = true;
+    if(node->refs.load(std::memory_order_relaxed) == 0) isViolated = true;
+
+    int left = dfsCheck(node->left, isViolated, count);
+    int right = dfsCheck(node->right, isViolated, count);
+    if(left != right) isViolated = true;
+    return left + (node->color == BLACK ? 1 : 0);
+}
+
+RB_VERSION_TEMPLATE
+template<class... Args>
+auto RB_PERSISTENT::create(Args&&... args) -> Node*{
+    Node* node = NodeTraits::allocate(alloc_, 1);
+    try{
+        NodeTraits::construct(alloc_, node, std::forward<Args>(args)...);
+    }
+    catch(...){
+        NodeTraits::deallocate(alloc_, node, 1);
+        throw;
+    }
+    return node;
+}
+
+/*
+a node referenced once is only reachable through the tree's own path (its parent was owned too),
+so it can be changed in place. otherwise copy it: the copy takes over the tree's reference and
+references the same children
+*/
+RB_VERSION_TEMPLATE
+auto RB_PERSISTENT::own(Node* node) -> Node*{
+    if(!node || node->refs.load(std::memory_order_acquire) == 1) return node;
+
+    Node* copy = create(node->key, node->value);
+    copy->color = node->color;
+    copy->left = node->left;
+    copy->right = node->right;
+    ref(copy->left);
+    ref(copy->right);
+    unref(node);
+    return copy;
+}
+
+RB_VERSION_TEMPLATE
+auto RB_PERSISTENT::linkTo(Node** path, int depth) -> Node*&{
+    if(depth == 0) return root_;
+    Node* parent = path[depth - 1];
+    return (parent->left == path[depth]) ? parent->left : parent->right;
+}
+
+RB_VERSION_TEMPLATE
+auto RB_PERSISTENT::leftRotation(Node*& link) -> Node*{
+    Node* node = link;
+    Node* child = node->right;
+    node->right = child->left;
+    child->left = node;
+    link = child;
+    return child;
+}
+
+RB_VERSION_TEMPLATE
+auto RB_PERSISTENT::rightRotation(Node*& link) -> Node*{
+    Node* node = link;
+    Node* child = node->left;
+    node->left = child->right;
+    child->right = node;
+    link = child;
+    return child;
+}
+
+/*
+fixInsert of RBTree, walking up the recorded path instead of parent links
+path[depth] is the new red node, every node on the path is owned.
+case 1, uncle is red -> recolor (the uncle is copied first when shared) -> continue with the grandparent
+case 2, node is the inner child -> rotate at the parent to case 3
+case 3, node is the outer child -> recolor and rotate at the grandparent -> done
+*/
+RB_VERSION_TEMPLATE
+void RB_PERSISTENT::fixInsert(Node** path, int depth){
+    while(depth >= 2 && path[depth - 1]->color == RED){
+        Node* node = path[depth];
+        Node* parent = path[depth - 1];
+        Node* grandparent = path[depth - 2];
+
+        if(parent == grandparent->left){
+            Node* uncle = grandparent->right;
+            //case 1
+            if(uncle && uncle->color == RED){
+                uncle = grandparent->right = own(uncle);
+                parent->color = BLACK;
+                uncle->color = BLACK;
+                grandparent->color = RED;
+                depth -= 2;
+                continue;
+            }
+            //case 2
+            if(node == parent->right) parent = leftRotation(grandparent->left);
+            //case 3
+            parent->color = BLACK;
+            grandparent->color = RED;
+            rightRotation(linkTo(path, depth - 2));
+        }
+        else{
+            Node* uncle = grandparent->left;
+            if(uncle && uncle->color == RED){
+                uncle = grandparent->left = own(uncle);
+                parent->color = BLACK;
+                uncle->color = BLACK;
+                grandparent->color = RED;
+                depth -= 2;
+                continue;
+            }
+            if(node == parent->left) parent = rightRotation(grandparent->right);
+            parent->color = BLACK;
+            grandparent->color = RED;
+            leftRotation(linkTo(path, depth - 2));
+        }
+        break;
+    }
+
+    root_->color = BLACK;
+}
+
+RB_VERSION_TEMPLATE
+template<class... Args>
+bool RB_PERSISTENT::emplace(const Key& newKey, Args&&... args){
+    //search without copying first, a duplicate must not copy the path
+    if(this->findNode(newKey)) return false;
+
+    //own every node on the way down
+    Node* path[maxTreeDepth];
+    int depth = 0;
+    Node** link = &root_;
+    while(*link){
+        Node* node = *link = own(*link);
+        path[depth++] = node;
+        link = comp_(newKey, node->key) ? &node->left : &node->right;
+    }
+
+    *link = path[depth] = create(newKey, std::forward<Args>(args)...);
+    size_++;
+    fixInsert(path, depth);
+    return true;
+}
+
+/*
+fixRemove of RBTree on the recorded path
+*xLink is the link which lost a black node (it may be null), path[parentDepth] is its owner.
+the sibling, and the nephew a case recolors, are copied when shared before they change.
+case 1, sibling is red -> recolor + rotate at the parent, the parent moves one level down the path
+case 2, sibling and both nephews are black -> recolor the sibling, continue with the parent
+case 3, the far nephew is black -> recolor + rotate at the sibling to case 4
+case 4, the far nephew is red -> recolor + rotate at the parent -> done
+*/
+RB_VERSION_TEMPLATE
+void RB_PERSISTENT::fixRemove(Node** path, int parentDepth, Node** xLink){
+    auto isBlack = [](const Node* node){ return !node || node->color == BLACK; };
+
+    while(parentDepth >= 0 && isBlack(*xLink)){
+        Node* parent = path[parentDepth];
+
+        if(xLink == &parent->left){
+            Node* sibling = parent->right = own(parent->right);
+            //case 1
+            if(sibling->color == RED){
+                sibling->color = BLACK;
+                parent->color = RED;
+                path[parentDepth] = leftRotation(linkTo(path, parentDepth));
+                path[++parentDepth] = parent;
+                sibling = parent->right = own(parent->right);
+            }
+            //case 2
+            if(isBlack(sibling->left) && isBlack(sibling->right)){
+                sibling->color = RED;
+                xLink = &linkTo(path, parentDepth);
+                parentDepth--;
+                continue;
+            }
+            //case 3
+            if(isBlack(sibling->right)){
+                sibling->left = own(sibling->left);
+                sibling->left->color = BLACK;
+                sibling->color = RED;
+                sibling = rightRotation(parent->right);
+            }
+            //case 4
+            sibling->color = parent->color;
+            parent->color = BLACK;
+            sibling->right = own(sibling->right);
+            sibling->right->color = BLACK;
+            leftRotation(linkTo(path, parentDepth));
+        }
+        else{
+            Node* sibling = parent->left = own(parent->left);
+            if(sibling->color == RED){
+                sibling->color = BLACK;
+                parent->color = RED;
+                path[parentDepth] = rightRotation(linkTo(path, parentDepth));
+                path[++parentDepth] = parent;
+                sibling = parent->left = own(parent->left);
+            }
+            if(isBlack(sibling->left) && isBlack(sibling->right)){
+                sibling->color = RED;
+                xLink = &linkTo(path, parentDepth);
+                parentDepth--;
+                continue;
+            }
+            if(isBlack(sibling->left)){
+                sibling->right = own(sibling->right);
+                sibling->right->color = BLACK;
+                sibling->color = RED;
+                sibling = leftRotation(parent->left);
+            }
+            sibling->color = parent->color;
+            parent->color = BLACK;
+            sibling->left = own(sibling->left);
+            sibling->left->color = BLACK;
+            rightRotation(linkTo(path, parentDepth));
+        }
+        return;
+    }
+
+    //a red node took the place of the black one, or the root: painting it black is enough
+    if(*xLink){
+        *xLink = own(*xLink);
+        (*xLink)->color = BLACK;
+    }
+}
+
+RB_VERSION_TEMPLATE
+bool RB_PERSISTENT::remove(const Key& oldKey){
+    if(!this->findNode(oldKey)) return false;
+
+    //own the path down to the node
+    Node* path[maxTreeDepth];
+    int depth = 0;
+    Node** link = &root_;
+    while(true){
+        Node* node = *link = own(*link);
+        path[depth] = node;
+        if(comp_(node->key, oldKey)) link = &node->right;
+        else if(comp_(oldKey, node->key)) link = &node->left;
+        else break;
+        depth++;
+    }
+
+    /*
+    two children: the successor's element moves into the node (it is owned, no version sees the change)
+    and the successor, which has no left child, is removed instead
+    */
+    Node* z = path[depth];
+    if(z->left && z->right){
+        link = &z->right;
+        while(true){
+            Node* node = *link = own(*link);
+            path[++depth] = node;
+            if(!node->left) break;
+            link = &node->left;
+        }
+        Node* successor = path[depth];
+        z->key = std::move(successor->key);
+        z->value = std::move(successor->value);
+        z = successor;
+    }
+
+    //unlink z, its only child (if any) takes its place
+    Node* child = z->left ? z->left : z->right;
+    *link = child;
+    z->left = z->right = nullptr;
+    Color removedColor = z->color;
+    unref(z);
+    size_--;
+
+    if(removedColor == BLACK) fixRemove(path, depth - 1, link);
+    return true;
+}
+
+#undef RB_VERSION_TEMPLATE
+#undef RB_VERSION
+#undef RB_PERSISTENT
+
+}   //namespace rb
@@ -0,0 +1,1997 @@
+#pragma once
+
+/*
+generic Red-Black Tree, the templated version of RBTreeImplement.c++
+
+    rb::RBTree<Key, Value, Compare, Allocator, Layout, Augment>
+    rb::RBSet<Key>          keys only (Value is the zero-size rb::Empty)
+    rb::RBMap<Key, Value>   keys with values, values may be move-only (use emplace)
+    rb::OrderStatisticSet<Key> / rb::OrderStatisticMap<Key, Value>
+                            with subtree sizes: select(k), rank(key), countRange(lo, hi)
+
+nodes come from Allocator, rebound to the node type. the default rb::NodePool keeps the
+nodes in big slabs, recycles freed nodes through a free list, and lets the destructor drop
+the whole tree at once instead of deleting node by node.
+pass std::allocator<Key> to get the old per-node new/delete behaviour.
+
+Layout (see NodeLayout.h) picks the node representation. the default PackedPointerLayout
+keeps the color in the parent pointer, IndexLayout uses 32-bit links into one node array.
+the tree only touches links through leftOf()/setLeft()/parentOf()/colorOf()... below,
+so the algorithms are the same for every layout.
+
+Augment (see Augment.h) adds data to the nodes. the default NoAugment compiles every update
+away, SubtreeSize keeps the size of every subtree for the order statistic queries.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Augment.h"
+#include "Counters.h"
+#include "NodeLayout.h"
+#include "NodePool.h"
+#include "TreeFile.h"
+
+namespace rb {
+
+//value type of sets, takes no space inside the node
+struct Empty {};
+
+/*
+what *it gives for maps: the key and a reference to the value (ValueRef is Value& or const Value&).
+its own type instead of a plain std::pair<const Key&, ValueRef>, so that it can have a common
+reference with the value_type std::pair<const Key, Value> (see the end of the file), which
+std::bidirectional_iterator asks for
+*/
+template<class Key, class ValueRef>
+struct ElementRef : std::pair<const Key&, ValueRef>{
+    using std::pair<const Key&, ValueRef>::pair;
+};
+
+//tag of the bulk-load constructor: the range is sorted by Compare and has no duplicates
+struct SortedUnique {};
+inline constexpr SortedUnique sortedUnique{};
+
+//all nodes records its key and value, the color, left node, right node, parent node come from the layout
+//and the augmented data (if any) from the augmentation
+template<class Key, class Value, class Layout, class Augment = NoAugment>
+struct RBNode : Layout::template Links<RBNode<Key, Value, Layout, Augment>>, Augment::NodeData{
+    Key key;
+    [[no_unique_address]] Value value;
+    // Constructor: new nodes are red by default, and their links are initially null.
+    template<class K, class... Args>
+    explicit RBNode(K&& newKey, Args&&... args)
+    : key(std::forward<K>(newKey)), value(std::forward<Args>(args)...) {}
+};
+
+/*
+Red-Black Tree Rule
+1.the color of each node is either red or black
+2.the color of the root is always black
+3.the color of the leaves(nullptr) are considered black
+4.no two consecutive red nodes are allowed (red nodes should not have red child)
+5.Every path from a node to its descendant leaves must contain the same number of black nodes
+*/
+template<class Key, class Value = Empty, class Compare = std::less<Key>, class Allocator = NodePool<Key>,
+         class Layout = PackedPointerLayout, class Augment = NoAugment>
+class RBTree{
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using key_compare = Compare;
+        using allocator_type = Allocator;
+        using size_type = std::size_t;
+        using Node = RBNode<Key, Value, Layout, Augment>;
+        using Store = typename Layout::template Store<Node, Allocator>;
+        using Ref = typename Node::Ref;       //Node* or 32-bit index, depending on the layout
+
+    private:
+        //root of the tree, number of nodes
+        //(split() leaves the size unknown instead of counting, size() recounts it once)
+        Ref root_;
+        mutable size_type size_;
+        mutable bool sizeKnown_;
+        [[no_unique_address]] Compare comp_;
+        Store store_;
+
+        //the concurrent wrapper reads the nodes directly for its lock-free lookups
+        template<class, class, class, class> friend class ConcurrentRBTree;
+
+        //link and color access, the only place which knows how a node is stored
+        Ref leftOf(Ref node) const { return store_.get(node).left; }
+        Ref rightOf(Ref node) const { return store_.get(node).right; }
+        Ref parentOf(Ref node) const { return store_.get(node).parent(); }
+        Color colorOf(Ref node) const { return store_.get(node).color(); }
+        const Key& keyOf(Ref node) const { return store_.get(node).key; }
+        void setLeft(Ref node, Ref child) { store_.get(node).left = child; }
+        void setRight(Ref node, Ref child) { store_.get(node).right = child; }
+        void setParent(Ref node, Ref newParent) { store_.get(node).setParent(newParent); }
+        void setColor(Ref node, Color newColor) { store_.get(node).setColor(newColor); }
+
+        //augmentation: pull() recomputes a node from its children, pullUp() every node up to the root
+        //both are empty without augmentation
+        size_type countOf(Ref node) const { return node ? store_.get(node).subtreeSize : 0; }
+        void pull(Ref node);
+        void pullUp(Ref node);
+
+        //some operation make the insert and remove function easier
+        void rightRotation(Ref node);        //right rotations used during balancing
+        void leftRotation(Ref node);         //left rotations used during balancing
+        void replace(Ref a, Ref b);         //replace node 'a' with node 'b' in the tree structure (but not deleting a)
+        Ref findSuccessor(Ref node) const;        //find the in-order successor (minimum in right subtree)
+        Ref findMaximum(Ref node) const;          //maximum in the subtree, mirror of findSuccessor
+        Ref nextOf(Ref node) const;               //in-order neighbours through the parent links
+        Ref prevOf(Ref node) const;
+        Ref lowerBoundOf(const Key& key) const;   //first node with key >= key
+        Ref upperBoundOf(const Key& key) const;   //first node with key > key
+        Ref findNode(const Key& key) const;
+
+        //ask the cache for a node we are about to visit
+        void prefetchNode(Ref node) const{
+#if defined(__GNUC__) || defined(__clang__)
+            if(node) __builtin_prefetch(&store_.get(node));
+#endif
+        }
+
+        //fix some problem and remain the property of BRTree, when we insert or remove nodes
+        bool fixInsert(Ref node);           //returns true when the black height of the whole tree grew
+        void fixRemove(Ref node, Ref parent);
+
+        //shared by every insert flavour: search, create the node only if the key is new, rebalance
+        template<class K, class... Args>
+        bool emplaceImpl(K&& key, Args&&... args) { return emplaceAt(root_, std::forward<K>(key), std::forward<Args>(args)...).second; }
+        //the same, searching down from 'start' (key has to belong into its subtree), returns the node with the key
+        template<class K, class... Args>
+        std::pair<Ref, bool> emplaceAt(Ref start, K&& key, Args&&... args);
+        void removeNode(Ref z);             //unlink and destroy z, rebalance
+
+        //batch helpers: where to start searching for a key greater than the finger's key
+        Ref climbFrom(Ref finger, const Key& key) const;
+        bool sizeAtMost(size_type limit) const;     //size() <= limit, counting at most limit + 1 nodes
+        template<class Element>
+        static const Key& elementKey(const Element& element);
+
+        //recursive helpers for cleanup, printing, dfs to check the number of black nodes
+        void clearTree(Ref node);
+        void printTreePreorder(Ref node) const;
+        std::uint32_t saveSubtree(Ref node, FileRecord<Key, Value>* records, std::uint32_t& next) const;
+        void pullSubtree(Ref node);
+        int dfsCheckBRTree(Ref node, bool& isViolated, size_type& count) const;
+        size_type heightOf(Ref node) const;
+        size_type countLess(const Key& key, bool orEqual) const;
+
+        /*
+        helpers of bulk load, join, split and the set operations
+        they work on detached subtrees (root has no parent) inside this tree's store and use root_
+        as scratch space while rebalancing, the real root is only set again at the end
+        */
+        struct Piece{
+            Ref root;
+            int blackHeight;        //black nodes on every path from root down to a leaf, root included
+        };
+        struct SplitResult{
+            Piece left;             //keys smaller than the split key
+            Ref found;              //the node holding the split key (detached), or null
+            Piece right;            //keys greater than the split key
+        };
+
+        template<class Element>
+        Ref createFrom(Element&& element);
+        template<class Next>
+        Ref buildSorted(size_type n, int depth, int redDepth, Next& next);
+        template<class Next>
+        Piece buildBalanced(size_type n, Next& next);
+        void collectInorder(Ref root, std::vector<Ref>& nodes) const;
+        Piece takeNodes(RBTree& source, Ref root, size_type& count);
+        Piece copyNodes(const RBTree& other);
+
+        int blackHeightOf(Ref node) const;
+        Piece join(Piece left, Ref middle, Piece right);
+        Piece join2(Piece left, Piece right);
+        SplitResult splitAt(Piece tree, const Key& splitKey);
+        Piece splitLast(Piece tree, Ref& last);
+        Piece unionPieces(Piece a, Piece b);
+        Piece intersectPieces(Piece a, const RBTree& other, Ref b);
+        Piece differencePieces(Piece a, const RBTree& other, Ref b);
+        void setRoot(Piece piece);
+
+        //empty tree on the same memory as 'other', used by split()
+        RBTree(const RBTree& other, Store&& store)
+        : root_(), size_(0), sizeKnown_(true), comp_(other.comp_), store_(std::move(store)) {}
+
+    public:
+        static constexpr bool isSet = std::is_same_v<Value, Empty>;
+
+        /*
+        bidirectional iterator over the keys in order, ++ and -- walk with the parent links
+        sets give const Key&, maps give a (const Key&, Value&) pair, key() and value() work for both
+        end() is the null node, --end() goes to the maximum
+        */
+        template<bool IsConst>
+        class Iterator{
+            private:
+                friend class RBTree;
+                using Tree = std::conditional_t<IsConst, const RBTree, RBTree>;
+                using ValueRef = std::conditional_t<IsConst, const Value&, Value&>;
+
+                Tree* tree_ = nullptr;
+                Ref node_ = Ref();
+
+                Iterator(Tree* tree, Ref node) : tree_(tree), node_(node) {}
+
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using difference_type = std::ptrdiff_t;
+                using value_type = std::conditional_t<isSet, Key, std::pair<const Key, Value>>;
+                using reference = std::conditional_t<isSet, const Key&, ElementRef<Key, ValueRef>>;
+
+                //maps hand out a pair by value, operator-> needs something to point at
+                struct ArrowProxy{
+                    reference ref;
+                    const reference* operator->() const { return &ref; }
+                };
+                using pointer = std::conditional_t<isSet, const Key*, ArrowProxy>;
+
+                Iterator() = default;
+
+                //iterator -> const_iterator
+                template<bool OtherConst> requires (IsConst && !OtherConst)
+                Iterator(const Iterator<OtherConst>& other) : tree_(other.tree_), node_(other.node_) {}
+
+                const Key& key() const { return tree_->keyOf(node_); }
+                ValueRef value() const { return tree_->store_.get(node_).value; }
+
+                reference operator*() const{
+                    if constexpr (isSet) return key();
+                    else return reference(key(), value());
+                }
+                pointer operator->() const{
+                    if constexpr (isSet) return &key();
+                    else return ArrowProxy{ **this };
+                }
+
+                Iterator& operator++(){
+                    node_ = tree_->nextOf(node_);
+                    //the right child is the next stop when it exists, start loading it now
+                    if(node_) tree_->prefetchNode(tree_->rightOf(node_));
+                    return *this;
+                }
+                Iterator operator++(int){
+                    Iterator old = *this;
+                    ++*this;
+                    return old;
+                }
+                Iterator& operator--(){
+                    node_ = node_ ? tree_->prevOf(node_) : tree_->findMaximum(tree_->root_);
+                    return *this;
+                }
+                Iterator operator--(int){
+                    Iterator old = *this;
+                    --*this;
+                    return old;
+                }
+
+                bool operator==(const Iterator& other) const { return node_ == other.node_; }
+                bool operator!=(const Iterator& other) const { return node_ != other.node_; }
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        //constructor, destructor, print, checkBRTree interface
+        RBTree();
+        explicit RBTree(const Compare& comp, const Allocator& alloc = Allocator());
+        explicit RBTree(const Allocator& alloc);
+
+        //O(n) bulk load from a sorted range without duplicates (keys for sets, (key, value) pairs for maps)
+        template<class InputIt>
+        RBTree(SortedUnique, InputIt first, InputIt last, const Compare& comp = Compare(), const Allocator& alloc = Allocator());
+        //moving takes the nodes and the pool, the moved-from tree starts over with a NodePool of its own
+        RBTree(RBTree&& other) noexcept;
+        RBTree& operator=(RBTree&& other) noexcept;
+        RBTree(const RBTree&) = delete;
+        RBTree& operator=(const RBTree&) = delete;
+        ~RBTree();
+
+        void print() const;
+        bool isValidRBTree() const;
+
+        /*
+        binary file with the nodes in key order and their colors (TreeFile.h), keys and values have to
+        be trivially copyable. load() replaces the content in O(n) without a single comparison-driven
+        insert, MappedRBTree.h serves the same file read-only straight from mmap.
+        both throw std::runtime_error on I/O errors, load() also on a damaged file (checksum, shape,
+        key order, red-black rules). a load() which throws leaves the tree as it was
+        */
+        void save(const std::string& path) const;
+        void load(const std::string& path);
+
+        size_type size() const;
+        size_type height() const { return heightOf(root_); }      //nodes on the longest root-to-leaf path, O(n)
+        bool empty() const { return !root_; }
+        void clear();
+        allocator_type get_allocator() const { return store_.get_allocator(); }
+        void reserve(size_type n) { store_.reserve(n); }        //only IndexLayout preallocates
+
+        //insert, emplace, remove interface; return false on duplicated / missing key
+        bool insert(const Key& key) { return emplaceImpl(key); }
+        bool insert(Key&& key) { return emplaceImpl(std::move(key)); }
+        template<class... Args>
+        bool emplace(const Key& key, Args&&... args) { return emplaceImpl(key, std::forward<Args>(args)...); }
+        template<class... Args>
+        bool emplace(Key&& key, Args&&... args) { return emplaceImpl(std::move(key), std::forward<Args>(args)...); }
+        bool remove(const Key& oldKey);
+
+        //replace the content by a sorted range without duplicates, O(n), no fixInsert at all
+        template<class InputIt>
+        void assignSorted(InputIt first, InputIt last);
+
+        /*
+        insert / remove many keys at once (keys for sets, (key, value) pairs for maps), any order,
+        duplicates inside the batch count once (the first wins). returns how many were inserted / removed.
+        the batch is sorted first, then
+          batch >= size() / batchRebuildRatio   merge with the tree in key order and rebuild, O(n + m log m),
+                                                the nodes already in the tree are relinked, not copied
+          smaller batches                       finger search: each key is searched from the node the previous
+                                                key touched, climbing only as far as needed, O(m log(n / m))
+        */
+        static constexpr size_type batchRebuildRatio = 4;
+        template<class InputIt>
+        size_type insertBatch(InputIt first, InputIt last);
+        template<class InputIt>
+        size_type removeBatch(InputIt first, InputIt last);
+
+        /*
+        join and split, O(log n) when both trees allocate from the same memory, otherwise the moved part
+        is copied over in O(its size). pointer layouts share it
+          - with std::allocator
+          - with one NodePool: build the second tree with RBTree(comp, first.get_allocator()), and
+            split() hands its result the pool of this tree
+        every default tree has its own NodePool, so joining two of them copies; IndexLayout always copies.
+
+        split() on shared memory stays O(log n) by not counting the moved keys: the first size() of either
+        half afterwards walks that half once, O(n) (O(1) with subtree sizes, which keep the count).
+        insertBatch / removeBatch don't pay for it, they count only up to their threshold.
+
+        WARNING: the tree returned by split() (pointer layouts with NodePool) allocates from the same
+        NodePool as this one. the two halves are NOT independent: NodePool has no locking, using them
+        from two threads at the same time is a data race. for halves on different threads use
+        std::allocator, or IndexLayout (its split copies into a new array)
+        */
+        void join(RBTree&& right);              //every key of 'right' must be greater than every key here
+        RBTree split(const Key& splitKey);      //keeps the keys < splitKey, returns the keys >= splitKey
+
+        //set operations built on join/split, O(m log(n/m + 1)) for sizes m <= n
+        void unionWith(RBTree&& other);         //on equal keys the element of this tree stays
+        void unionWith(const RBTree& other);
+        void intersectWith(const RBTree& other);
+        void differenceWith(const RBTree& other);
+
+        //iteration, in key order
+        iterator begin() { return iterator(this, findSuccessor(root_)); }
+        iterator end() { return iterator(this, Ref()); }
+        const_iterator begin() const { return const_iterator(this, findSuccessor(root_)); }
+        const_iterator end() const { return const_iterator(this, Ref()); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+        reverse_iterator rbegin() { return reverse_iterator(end()); }
+        reverse_iterator rend() { return reverse_iterator(begin()); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+        //lookups, O(log n)
+        iterator find(const Key& key) { return iterator(this, findNode(key)); }
+        const_iterator find(const Key& key) const { return const_iterator(this, findNode(key)); }
+        bool contains(const Key& key) const { return static_cast<bool>(findNode(key)); }
+        iterator lower_bound(const Key& key) { return iterator(this, lowerBoundOf(key)); }
+        const_iterator lower_bound(const Key& key) const { return const_iterator(this, lowerBoundOf(key)); }
+        iterator upper_bound(const Key& key) { return iterator(this, upperBoundOf(key)); }
+        const_iterator upper_bound(const Key& key) const { return const_iterator(this, upperBoundOf(key)); }
+        std::pair<iterator, iterator> equal_range(const Key& key) { return { lower_bound(key), upper_bound(key) }; }
+        std::pair<const_iterator, const_iterator> equal_range(const Key& key) const { return { lower_bound(key), upper_bound(key) }; }
+
+        /*
+        range scans without iterators, the fast path for walking many keys:
+        an explicit stack instead of climbing parent links, and the right child of every node
+        is prefetched when the node is pushed, long before the scan gets there.
+        fn(key) for sets, fn(key, value) for maps
+        */
+        template<class Function>
+        void forEach(Function&& fn) const;
+        template<class Function>
+        void forEachInRange(const Key& lo, const Key& hi, Function&& fn) const;     //keys in [lo, hi]
+
+        //order statistics, only with the SubtreeSize augmentation, all O(log n)
+        const Key& select(size_type k) const requires Augment::enabled;    //k-th smallest key, from 0
+        size_type rank(const Key& key) const requires Augment::enabled;    //number of keys < key
+        size_type countRange(const Key& lo, const Key& hi) const requires Augment::enabled;    //keys in [lo, hi]
+};
+
+template<class Key, class Compare = std::less<Key>, class Allocator = NodePool<Key>, class Layout = PackedPointerLayout,
+         class Augment = NoAugment>
+using RBSet = RBTree<Key, Empty, Compare, Allocator, Layout, Augment>;
+
+template<class Key, class Value, class Compare = std::less<Key>, class Allocator = NodePool<Key>,
+         class Layout = PackedPointerLayout, class Augment = NoAugment>
+using RBMap = RBTree<Key, Value, Compare, Allocator, Layout, Augment>;
+
+template<class Key, class Compare = std::less<Key>, class Allocator = NodePool<Key>, class Layout = PackedPointerLayout>
+using OrderStatisticSet = RBTree<Key, Empty, Compare, Allocator, Layout, SubtreeSize>;
+
+template<class Key, class Value, class Compare = std::less<Key>, class Allocator = NodePool<Key>,
+         class Layout = PackedPointerLayout>
+using OrderStatisticMap = RBTree<Key, Value, Compare, Allocator, Layout, SubtreeSize>;
+
+#define RB_TEMPLATE template<class Key, class Value, class Compare, class Allocator, class Layout, class Augment>
+#define RB_TREE RBTree<Key, Value, Compare, Allocator, Layout, Augment>
+
+//just set the root initial condition, nullptr
+RB_TEMPLATE
+RB_TREE::RBTree() : root_(), size_(0), sizeKnown_(true), comp_(), store_(Allocator()) {}
+
+RB_TEMPLATE
+RB_TREE::RBTree(const Compare& comp, const Allocator& alloc) : root_(), size_(0), sizeKnown_(true), comp_(comp), store_(alloc) {}
+
+RB_TEMPLATE
+RB_TREE::RBTree(const Allocator& alloc) : root_(), size_(0), sizeKnown_(true), comp_(), store_(alloc) {}
+
+//take over the nodes, the other tree is left empty
+RB_TEMPLATE
+RB_TREE::RBTree(RBTree&& other) noexcept
+: root_(other.root_), size_(other.size_), sizeKnown_(other.sizeKnown_), comp_(std::move(other.comp_)),
+  store_(std::move(other.store_)) {
+    other.root_ = Ref();
+    other.size_ = 0;
+    other.sizeKnown_ = true;
+}
+
+RB_TEMPLATE
+RB_TREE& RB_TREE::operator=(RBTree&& other) noexcept{
+    if(this == &other) return *this;
+
+    clear();
+    root_ = other.root_;
+    size_ = other.size_;
+    sizeKnown_ = other.sizeKnown_;
+    comp_ = std::move(other.comp_);
+    store_ = std::move(other.store_);
+    other.root_ = Ref();
+    other.size_ = 0;
+    other.sizeKnown_ = true;
+    return *this;
+}
+
+//bulk load, see assignSorted
+RB_TEMPLATE
+template<class InputIt>
+RB_TREE::RBTree(SortedUnique, InputIt first, InputIt last, const Compare& comp, const Allocator& alloc)
+: root_(), size_(0), sizeKnown_(true), comp_(comp), store_(alloc) {
+    assignSorted(first, last);
+}
+
+//use clear function to destructor the whole tree
+RB_TEMPLATE
+RB_TREE::~RBTree(){
+    clear();
+}
+
+/*
+remove every node
+nodes without destructor don't need to be visited at all, when the store can release
+its memory at once (rb::NodePool slabs, the IndexLayout array), the whole tree is dropped
+in O(number of slabs)
+*/
+RB_TEMPLATE
+void RB_TREE::clear(){
+    bool released = false;
+    if constexpr (std::is_trivially_destructible_v<Node>) released = store_.release();
+    if(!released) clearTree(this->root_);
+
+    this->root_ = Ref();
+    this->size_ = 0;
+    this->sizeKnown_ = true;
+}
+
+//number of keys, counted once after a split() (or read from the root with subtree sizes)
+RB_TEMPLATE
+auto RB_TREE::size() const -> size_type{
+    if constexpr (Augment::enabled){
+        if(!sizeKnown_){
+            size_ = countOf(root_);
+            sizeKnown_ = true;
+        }
+    }
+    if(!sizeKnown_){
+        std::vector<Ref> nodes;
+        collectInorder(root_, nodes);
+        size_ = nodes.size();
+        sizeKnown_ = true;
+    }
+    return size_;
+}
+
+//nodes on the longest path down from node, at most 2 log2(n + 1) deep in a valid tree
+RB_TEMPLATE
+auto RB_TREE::heightOf(Ref node) const -> size_type{
+    if(!node) return 0;
+    return 1 + std::max(heightOf(leftOf(node)), heightOf(rightOf(node)));
+}
+
+//print the entire tree using pre-order traversal
+RB_TEMPLATE
+void RB_TREE::print() const {printTreePreorder(this->root_);}
+
+//the records of a subtree in key order, returns the record index of node
+RB_TEMPLATE
+std::uint32_t RB_TREE::saveSubtree(Ref node, FileRecord<Key, Value>* records, std::uint32_t& next) const{
+    if(!node) return 0;
+
+    std::uint32_t left = saveSubtree(leftOf(node), records, next);
+    std::uint32_t index = ++next;
+    std::uint32_t right = saveSubtree(rightOf(node), records, next);
+
+    FileRecord<Key, Value>& record = records[index - 1];
+    record.left = left;
+    record.rightColor = (right << 1) | colorOf(node);
+    record.key = keyOf(node);
+    record.value = store_.get(node).value;
+    return index;
+}
+
+RB_TEMPLATE
+void RB_TREE::save(const std::string& path) const{
+    using Record = FileRecord<Key, Value>;
+    if(size() > maxFileRecords) throw std::length_error("rb::RBTree::save: more than 2^31 - 1 keys");
+
+    //value initialized, so the padding inside the records is written as zeros
+    std::vector<Record> records(size());
+    std::uint32_t next = 0;
+    std::uint32_t root = saveSubtree(root_, records.data(), next);
+    FileHeader header = makeFileHeader<Key, Value>(records.size(), root, checksum(records.data(), records.size() * sizeof(Record)));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record)));
+    out.close();
+    if(!out) throw std::runtime_error("rb::RBTree::save: cannot write " + path);
+}
+
+//recompute the augmented data of a whole subtree, children first
+RB_TEMPLATE
+void RB_TREE::pullSubtree(Ref node){
+    if(!node) return;
+    pullSubtree(leftOf(node));
+    pullSubtree(rightOf(node));
+    pull(node);
+}
+
+RB_TEMPLATE
+void RB_TREE::load(const std::string& path){
+    using Record = FileRecord<Key, Value>;
+
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if(!in) throw std::runtime_error("rb::RBTree::load: cannot open " + path);
+    std::uint64_t fileSize = static_cast<std::uint64_t>(in.tellg());
+    in.seekg(0);
+
+    FileHeader header;
+    if(fileSize < sizeof(header) || !in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        throw std::runtime_error("rb::RBTree::load: truncated file " + path);
+    checkFileHeader<Key, Value>(header, fileSize);
+
+    std::vector<Record> records(header.count);
+    in.seekg(static_cast<std::streamoff>(header.recordOffset));
+    if(!in.read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record))))
+        throw std::runtime_error("rb::RBTree::load: truncated file " + path);
+
+    //everything is checked before the first node exists
+    if(checksum(records.data(), records.size() * sizeof(Record)) != header.checksum)
+        throw std::runtime_error("rb::RBTree::load: checksum mismatch in " + path);
+    if(!checkFileShape(records.data(), header.count, header.root))
+        throw std::runtime_error("rb::RBTree::load: corrupt tree in " + path);
+    for(size_type i = 1; i < records.size(); i++){
+        if(!comp_(records[i - 1].key, records[i].key)) throw std::runtime_error("rb::RBTree::load: keys out of order in " + path);
+    }
+
+    /*
+    the red-black rules can only be checked on linked nodes: they go into a tree of their own,
+    which replaces the content only when it passes, so a failed load() leaves this tree alone.
+    nodes are created in key order, like the bulk load, then linked as they were saved
+    */
+    RBTree loaded(*this, store_.sibling());
+    loaded.store_.reserve(records.size());
+    std::vector<Ref> nodes;
+    nodes.reserve(records.size());
+    try{
+        for(const Record& record : records) nodes.push_back(loaded.store_.create(record.key, record.value));
+    }
+    catch(...){
+        for(Ref node : nodes) loaded.store_.destroy(node);
+        throw;
+    }
+
+    auto nodeAt = [&](std::uint32_t index){ return index ? nodes[index - 1] : Ref(); };
+    for(size_type i = 0; i < records.size(); i++){
+        Ref left = nodeAt(records[i].left);
+        Ref right = nodeAt(records[i].right());
+        loaded.setLeft(nodes[i], left);
+        loaded.setRight(nodes[i], right);
+        if(left) loaded.setParent(left, nodes[i]);
+        if(right) loaded.setParent(right, nodes[i]);
+        loaded.setColor(nodes[i], records[i].color());
+    }
+
+    loaded.root_ = nodeAt(header.root);
+    if(loaded.root_) loaded.setParent(loaded.root_, Ref());
+    loaded.size_ = records.size();
+    if constexpr (Augment::enabled) loaded.pullSubtree(loaded.root_);
+
+    if(!loaded.isValidRBTree()) throw std::runtime_error("rb::RBTree::load: " + path + " breaks the red-black rules");
+    *this = std::move(loaded);
+}
+
+//check if the tree BRTree
+RB_TEMPLATE
+bool RB_TREE::isValidRBTree() const {
+    if (!root_) return !sizeKnown_ || size_ == 0;  //nullptr considered true
+
+    //root should be black and has no parent
+    if (colorOf(root_) != BLACK || parentOf(root_)) return false;
+
+    bool isViolated = false;
+    size_type count = 0;
+    dfsCheckBRTree(this->root_, isViolated, count);
+    return !isViolated && (!sizeKnown_ || count == size_);
+}
+
+//dfs to check if the tree BRTree, also checks the key order, the parent links and counts the nodes
+RB_TEMPLATE
+int RB_TREE::dfsCheckBRTree(Ref node, bool& isViolated, size_type& count) const{
+    //define the black-height of empty tree is one
+    if(!node) return 1;
+    count++;
+
+    Ref left = leftOf(node);
+    Ref right = rightOf(node);
+
+    //check if consecutive red nodes
+    if(colorOf(node) == RED){
+        if(right && colorOf(right) == RED) isViolated = true;
+        if(left && colorOf(left) == RED) isViolated = true;
+    }
+
+    //check the children point back to node and are on the correct side
+    if(left && (parentOf(left) != node || !comp_(keyOf(left), keyOf(node)))) isViolated = true;
+    if(right && (parentOf(right) != node || !comp_(keyOf(node), keyOf(right)))) isViolated = true;
+
+    if(isViolated) return -1;
+
+    //check if the two path has different numbers of nodes
+    size_type countBefore = count;
+    int leftHeight = dfsCheckBRTree(left, isViolated, count);
+    int rightHeight = dfsCheckBRTree(right, isViolated, count);
+
+    //the subtree size has to match the nodes counted below this node
+    if constexpr (Augment::enabled){
+        if(countOf(node) != count - countBefore + 1) isViolated = true;
+    }
+
+    if(isViolated || leftHeight != rightHeight){
+        isViolated = true;
+        return -1;
+    }
+
+    return ( ((colorOf(node) == BLACK) ? 1 : 0) + leftHeight );
+}
+
+//pre-order traversal: node -> left -> right
+RB_TEMPLATE
+void RB_TREE::printTreePreorder(Ref node) const{
+    //if the node dose not exist, return directly
+    if(!node) return;
+
+    Ref left = leftOf(node);
+    Ref right = rightOf(node);
+
+    //print node's key and color, left(if it exist)'s key and color, right(if it exist)'s key and color
+    std::cout << "node: " << keyOf(node) << ((colorOf(node) == RED) ? "R" : "B") << " ";
+    if(left){
+        std::cout << "left: " << keyOf(left) << ((colorOf(left) == RED) ? "R" : "B") << " ";
+    }
+    else{
+        std::cout << "left: " << "nullptr" << " ";
+    }
+    if(right){
+        std::cout << "right: " << keyOf(right) << ((colorOf(right) == RED) ? "R" : "B") << " ";
+    }
+    else{
+        std::cout << "right: " << "nullptr" << " ";
+    }
+    std::cout << std::endl;
+
+    //after print node, then traverse to left
+    if(left) printTreePreorder(left);
+
+    //after print node, then traverse to right
+    if(right) printTreePreorder(right);
+}
+
+//post-order to delete nodes: left -> right -> node
+RB_TEMPLATE
+void RB_TREE::clearTree(Ref node){
+    //if the node does not exist, return directly
+    if(!node) return;
+
+    //traverse to left
+    clearTree(leftOf(node));
+
+    //traverse to right
+    clearTree(rightOf(node));
+
+    //delete the node itself
+    store_.destroy(node);
+    this->size_--;
+}
+
+//perform a right rotation on the given node
+RB_TEMPLATE
+void RB_TREE::rightRotation(Ref node){
+    //if the node or its left child does not exist, return directly
+    if(!node || !leftOf(node)) return;
+
+    Ref child = leftOf(node);
+
+    //step 1: move child's right subtree to node's left
+    setLeft(node, rightOf(child));
+    if(rightOf(child)) setParent(rightOf(child), node);
+
+    //step 2: adjust child's parent pointer
+    replace(node, child);
+
+    //step 3: adjust the relation between node and child
+    setRight(child, node);
+    setParent(node, child);
+
+    //node is below child now, recompute it first
+    pull(node);
+    pull(child);
+}
+
+//perform a left rotation on the given node
+RB_TEMPLATE
+void RB_TREE::leftRotation(Ref node){
+    //if the node or its right child does not exist, return directly
+    if(!node || !rightOf(node)) return;
+
+    Ref child = rightOf(node);
+
+    //step 1: move child's left subtree to node's right
+    setRight(node, leftOf(child));
+    if(leftOf(child)) setParent(leftOf(child), node);
+
+    //step 2: adjust child's parent pointer
+    replace(node, child);
+
+    //step 3: adjust the relation between node and child
+    setLeft(child, node);
+    setParent(node, child);
+
+    //node is below child now, recompute it first
+    pull(node);
+    pull(child);
+}
+
+/*
+replace node 'a' with node 'b' in the tree structure (but not deleting a)
+ONLY adjust parent-child linkage
+DOES NOT adjust the information about a and b's children here
+*/
+RB_TEMPLATE
+void RB_TREE::replace(Ref a, Ref b){
+    Ref aParent = parentOf(a);
+
+    //adjust information of a's parent
+    if(!aParent) this->root_ = b;         //no parent -> node is root -> adjust root
+    else if(leftOf(aParent) == a) setLeft(aParent, b);
+    else setRight(aParent, b);
+
+    //adjust information of b
+    if(b) setParent(b, aParent);
+}
+
+/*
+return the node with the minimum key in the subtree rooted at 'node'
+(i.e., the leftmost node in the subtree)
+*/
+RB_TEMPLATE
+auto RB_TREE::findSuccessor(Ref node) const -> Ref{
+    //keep searching in left subtree
+    Ref prev = Ref();
+    while(node){
+        prev = node;
+        node = leftOf(node);
+    }
+
+    return prev;
+}
+
+//maximum of the subtree: the rightmost node
+RB_TEMPLATE
+auto RB_TREE::findMaximum(Ref node) const -> Ref{
+    Ref prev = Ref();
+    while(node){
+        prev = node;
+        node = rightOf(node);
+    }
+
+    return prev;
+}
+
+//next node in key order: minimum of the right subtree, or the first ancestor we are in the left subtree of
+RB_TEMPLATE
+auto RB_TREE::nextOf(Ref node) const -> Ref{
+    if(rightOf(node)) return findSuccessor(rightOf(node));
+
+    Ref parent = parentOf(node);
+    while(parent && rightOf(parent) == node){
+        node = parent;
+        parent = parentOf(node);
+    }
+    return parent;
+}
+
+//previous node in key order, the mirror of nextOf
+RB_TEMPLATE
+auto RB_TREE::prevOf(Ref node) const -> Ref{
+    if(leftOf(node)) return findMaximum(leftOf(node));
+
+    Ref parent = parentOf(node);
+    while(parent && leftOf(parent) == node){
+        node = parent;
+        parent = parentOf(node);
+    }
+    return parent;
+}
+
+RB_TEMPLATE
+auto RB_TREE::findNode(const Key& key) const -> Ref{
+    Ref node = root_;
+    while(node){
+        if(comp_(keyOf(node), key)) node = rightOf(node);
+        else if(comp_(key, keyOf(node))) node = leftOf(node);
+        else break;
+    }
+    return node;
+}
+
+//remember the last node we went left at, that is the first key not smaller than key
+RB_TEMPLATE
+auto RB_TREE::lowerBoundOf(const Key& key) const -> Ref{
+    Ref node = root_;
+    Ref bound = Ref();
+    while(node){
+        if(comp_(keyOf(node), key)) node = rightOf(node);
+        else{
+            bound = node;
+            node = leftOf(node);
+        }
+    }
+    return bound;
+}
+
+RB_TEMPLATE
+auto RB_TREE::upperBoundOf(const Key& key) const -> Ref{
+    Ref node = root_;
+    Ref bound = Ref();
+    while(node){
+        if(comp_(key, keyOf(node))){
+            bound = node;
+            node = leftOf(node);
+        }
+        else node = rightOf(node);
+    }
+    return bound;
+}
+
+RB_TEMPLATE
+template<class Function>
+void RB_TREE::forEach(Function&& fn) const{
+    if(!root_) return;
+    forEachInRange(keyOf(findSuccessor(root_)), keyOf(findMaximum(root_)), std::forward<Function>(fn));
+}
+
+/*
+in-order scan of [lo, hi]
+the stack holds the nodes whose key is still to be visited, the way down to lo only pushes
+nodes >= lo, and the scan stops at the first key > hi
+*/
+RB_TEMPLATE
+template<class Function>
+void RB_TREE::forEachInRange(const Key& lo, const Key& hi, Function&& fn) const{
+    if(comp_(hi, lo)) return;
+
+    Ref stack[maxTreeDepth];
+    int top = 0;
+
+    Ref node = root_;
+    while(node){
+        if(comp_(keyOf(node), lo)) node = rightOf(node);
+        else{
+            prefetchNode(rightOf(node));
+            stack[top++] = node;
+            node = leftOf(node);
+        }
+    }
+
+    while(top > 0){
+        node = stack[--top];
+        if(comp_(hi, keyOf(node))) return;
+
+        if constexpr (isSet) fn(keyOf(node));
+        else fn(keyOf(node), store_.get(node).value);
+
+        //the next keys are in the left spine of the right subtree
+        for(node = rightOf(node); node; node = leftOf(node)){
+            prefetchNode(rightOf(node));
+            stack[top++] = node;
+        }
+    }
+}
+
+/*
+fix violations of Red-Black Tree properties caused by insertion.
+
+we only need to consider the two consecutive red nodes
+case 1, uncle node is also red -> only need to adjust the color
+case 2, uncle node is black & node is in LR or RL path of grandparent -> rotation to make it LL or RR(case 3)
+case 3, uncle node is black & node is in LL or RR path of grandparent -> adjust the color + rotation
+*/
+RB_TEMPLATE
+bool RB_TREE::fixInsert(Ref node){
+
+    //node is red -> node's parent exist -> check if node and node's parent are consecutive red nodes
+    while(node != this->root_ && node && colorOf(node) == RED && colorOf(parentOf(node)) == RED){
+        RB_COUNT(insertFixupLoops);
+
+        Ref parent = parentOf(node);
+        Ref grandparent = parentOf(parent);         //grand parent should exist, because node->parent is red
+
+        //case: node is at the left side of grandparent
+        if(leftOf(grandparent) == parent){
+            Ref uncle = rightOf(grandparent);       //uncle is in the right side of grandparent
+
+            //case 1, uncle is red
+            if(uncle && colorOf(uncle) == RED){
+                RB_COUNT(insertCase1);
+                setColor(parent, BLACK);
+                setColor(uncle, BLACK);
+                setColor(grandparent, RED);
+
+                //up to check grandparent
+                node = grandparent;
+                continue;
+            }
+
+            //check if case 2, node in LR of grandparent
+            if(rightOf(parent) == node){
+                RB_COUNT(insertCase2);
+                RB_COUNT(insertRotations);
+                leftRotation(parent);
+                node = parent;
+                parent = parentOf(node);
+            }
+
+            //deal with case 3, node in LL of grandparent
+            RB_COUNT(insertCase3);
+            RB_COUNT(insertRotations);
+            setColor(grandparent, RED);
+            setColor(parent, BLACK);
+            rightRotation(grandparent);
+
+            //up to check parent
+            node = parent;
+        }
+        //case: node is at the right side of grandparent
+        else{
+            Ref uncle = leftOf(grandparent);       //uncle is in the left side of grandparent
+
+            //case 1, uncle is red
+            if(uncle && colorOf(uncle) == RED){
+                RB_COUNT(insertCase1);
+                setColor(parent, BLACK);
+                setColor(uncle, BLACK);
+                setColor(grandparent, RED);
+
+                //up to check grandparent
+                node = grandparent;
+                continue;
+            }
+
+            //check if case 2, node in RL of grandparent
+            if(leftOf(parent) == node){
+                RB_COUNT(insertCase2);
+                RB_COUNT(insertRotations);
+                rightRotation(parent);
+                node = parent;
+                parent = parentOf(node);
+            }
+
+            //deal with case 3, node in RR of grandparent
+            RB_COUNT(insertCase3);
+            RB_COUNT(insertRotations);
+            setColor(grandparent, RED);
+            setColor(parent, BLACK);
+            leftRotation(grandparent);
+
+            //up to check parent
+            node = parent;
+        }
+    }
+
+    //remain the root black, directly adjusting root to black won't violate anything
+    //(a red root turning black adds one black node to every path)
+    if(!this->root_ || colorOf(this->root_) == BLACK) return false;
+    setColor(this->root_, BLACK);
+    return true;
+}
+
+//insert the new node just like BST, remain RBTree properties additionally
+RB_TEMPLATE
+template<class K, class... Args>
+auto RB_TREE::emplaceAt(Ref start, K&& newKey, Args&&... args) -> std::pair<Ref, bool>{
+    //traverse to find the correct insertion point
+    Ref node = start;
+    Ref prev = Ref();
+    bool goLeft = false;
+    while(node){
+        prev = node;
+
+        if(comp_(keyOf(node), newKey)) { node = rightOf(node); goLeft = false; }      //turn right
+        else if(comp_(newKey, keyOf(node))) { node = leftOf(node); goLeft = true; }   //turn left
+        else return { node, false };        //return due to duplication
+    }
+
+    //generate new node with necessary information
+    Ref newNode = store_.create(std::forward<K>(newKey), std::forward<Args>(args)...);
+    setParent(newNode, prev);
+
+    //adjust information of prev
+    if(!prev) this->root_ = newNode;
+    else if(goLeft) setLeft(prev, newNode);
+    else setRight(prev, newNode);
+    this->size_++;
+    pullUp(prev);
+    RB_COUNT(inserts);
+
+    //remain RBTree properties
+    fixInsert(newNode);
+    return { newNode, true };
+}
+
+/*
+fix violations of Red-Black Tree properties caused by removal.
+
+we only need to consider we remove black node,
+because that means we decrease the number of black nodes in one subtree,
+which violate the properties of RBTree
+
+case 1, sibling node is red -> adjust the color + rotation -> adjust sibling and continue to case 234
+case 2, sibling node is black & its left and right children are black -> adjust the color -> to deal with upper layer of tree
+case 3, (sibling in parent's right and siblingLeft is red) or (sibling in parent's left and siblingRight is red)
+        -> adjust the color + rotation to case4 -> adjust sibling and continue to case 4
+case 4, (sibling in parent's right and siblingRight is red) or (sibling in parent's left and siblingLeft is red)
+        -> adjust the color + rotation -> complete and jump out the loop
+Last, set the node black wherever the node is
+*/
+RB_TEMPLATE
+void RB_TREE::fixRemove(Ref node, Ref parent){
+
+    while((!node || colorOf(node) == BLACK) && node != root_){       //loop when the node's color is black
+        RB_COUNT(removeFixupLoops);
+        //case: node is in the left side of parent
+        if(leftOf(parent) == node){
+            Ref sibling = rightOf(parent);      //sibling is in the right side of parent
+
+            //case 1, sibling is red
+            if(sibling && colorOf(sibling) == RED){
+                RB_COUNT(removeCase1);
+                RB_COUNT(removeRotations);
+                setColor(sibling, BLACK);
+                setColor(parent, RED);
+                leftRotation(parent);
+
+                sibling = rightOf(parent);
+            }
+
+            //we aren't sure whether sibling exist
+            Ref siblingLeft = (sibling) ? leftOf(sibling) : Ref();
+            Ref siblingRight = (sibling) ? rightOf(sibling) : Ref();
+
+            //case 2, sibling is black and both of its children are black
+            if((!siblingLeft || colorOf(siblingLeft) == BLACK)
+            && (!siblingRight || colorOf(siblingRight) == BLACK)){
+                RB_COUNT(removeCase2);
+                if(sibling) setColor(sibling, RED);
+
+                node = parent;
+                parent = parentOf(node);
+                continue;
+            }
+
+            //case 3, sibling is black and its left child is red
+            if(!siblingRight || colorOf(siblingRight) == BLACK){
+                RB_COUNT(removeCase3);
+                RB_COUNT(removeRotations);
+                if(siblingLeft) setColor(siblingLeft, BLACK);
+                if(sibling) setColor(sibling, RED);
+                rightRotation(sibling);
+                sibling = rightOf(parent);
+            }
+
+            //sibling may be changed by front case
+            siblingLeft = (sibling) ? leftOf(sibling) : Ref();
+            siblingRight = (sibling) ? rightOf(sibling) : Ref();
+
+            //csae 4, sibling is black and its right child is red
+            RB_COUNT(removeCase4);
+            RB_COUNT(removeRotations);
+            if(sibling) setColor(sibling, colorOf(parent));
+            setColor(parent, BLACK);
+            if(siblingRight) setColor(siblingRight, BLACK);
+            leftRotation(parent);
+            node = this->root_;
+        }
+        //case: node is in the right side of parent
+        else{
+            Ref sibling = leftOf(parent);      //sibling is in the left side of parent
+
+            //case 1, sibling is red
+            if(sibling && colorOf(sibling) == RED){
+                RB_COUNT(removeCase1);
+                RB_COUNT(removeRotations);
+                setColor(sibling, BLACK);
+                setColor(parent, RED);
+                rightRotation(parent);
+
+                sibling = leftOf(parent);
+            }
+
+            //we aren't sure whether sibling exist
+            Ref siblingLeft = (sibling) ? leftOf(sibling) : Ref();
+            Ref siblingRight = (sibling) ? rightOf(sibling) : Ref();
+
+            //case 2, sibling is black and both of its children are black
+            if((!siblingLeft || colorOf(siblingLeft) == BLACK)
+            && (!siblingRight || colorOf(siblingRight) == BLACK)){
+                RB_COUNT(removeCase2);
+                if(sibling) setColor(sibling, RED);
+
+                node = parent;
+                parent = parentOf(node);
+                continue;
+            }
+
+            //case 3, sibling is black and its right child is red
+            if(!siblingLeft || colorOf(siblingLeft) == BLACK){
+                RB_COUNT(removeCase3);
+                RB_COUNT(removeRotations);
+                if(siblingRight) setColor(siblingRight, BLACK);
+                if(sibling) setColor(sibling, RED);
+                leftRotation(sibling);
+                sibling = leftOf(parent);
+            }
+
+            //sibling may be changed by front case
+            siblingLeft = (sibling) ? leftOf(sibling) : Ref();
+            siblingRight = (sibling) ? rightOf(sibling) : Ref();
+
+            //case 4, sibling is black and its left child is red
+            RB_COUNT(removeCase4);
+            RB_COUNT(removeRotations);
+            if(sibling) setColor(sibling, colorOf(parent));
+            setColor(parent, BLACK);
+            if(siblingLeft) setColor(siblingLeft, BLACK);
+            rightRotation(parent);
+            node = this->root_;
+        }
+    }
+
+    if(node) setColor(node, BLACK);
+}
+
+/*
+    delete the node just like BST
+        case 1, the node has no children
+        case 2, the node has only left child
+        case 3, the node has only right child
+        case 4, the node has both children
+
+    z is the node to be delete originally
+    y is the node to be delete actually(happen in case 4)
+    x is the node to replace the position which is deleted
+    xParent is x's parent after deleting node
+
+    in case 4 the successor node itself is moved into z's place (keys are never copied),
+    so move-only values work and other nodes never change their key
+*/
+RB_TEMPLATE
+bool RB_TREE::remove(const Key& oldKey){
+    //traverse to find the correct deleting position
+    Ref z = this->root_;
+    while(z){
+        if(comp_(keyOf(z), oldKey)) z = rightOf(z);
+        else if(comp_(oldKey, keyOf(z))) z = leftOf(z);
+        else break;
+    }
+
+    //if key not exist
+    if(!z) return false;
+
+    removeNode(z);
+    return true;
+}
+
+RB_TEMPLATE
+void RB_TREE::removeNode(Ref z){
+    Ref x = Ref();
+    Ref xParent = Ref();
+    Ref y = z;
+    //z's children do not change until z is unlinked
+    Ref zLeft = leftOf(z);
+    Ref zRight = rightOf(z);
+
+    Color yOriginalColor = colorOf(y);
+
+    //case 1, no child
+    if(!zLeft && !zRight){
+        Ref zParent = parentOf(z);
+        if(!zParent) this->root_ = Ref();      //no parent -> root
+        else if(leftOf(zParent) == z) setLeft(zParent, Ref());   //left child
+        else setRight(zParent, Ref());     //right child
+
+        xParent = zParent;
+    }
+    //case 2, only has left child
+    else if(!zRight){
+        x = zLeft;
+        xParent = parentOf(z);
+        replace(z, x);
+    }
+    //case 3, only has right child
+    else if(!zLeft){
+        x = zRight;
+        xParent = parentOf(z);
+        replace(z, x);
+    }
+    //case 4, has both children
+    else{
+        //first find the successor, the minimum in right subtree
+        y = findSuccessor(zRight);
+        x = rightOf(y);
+        yOriginalColor = colorOf(y);
+
+        //adjust successor from successor's right
+        if(y == zRight){      //y is z's right -> adjust x's parent -> the left adjustment will be done later
+            if(x) setParent(x, y);
+            xParent = y;
+        }
+        else{       //other situation -> x should replace y
+            xParent = parentOf(y);
+
+            replace(y, x);
+
+            //adjust the connection between z & z's right
+            setParent(zRight, y);
+            setRight(y, zRight);
+
+        }
+
+        //replace node from successor
+        replace(z, y);
+
+        //adjust the connection between z & z's left
+        setParent(zLeft, y);
+        setLeft(y, zLeft);
+        setColor(y, colorOf(z));
+    }
+
+    store_.destroy(z);
+    this->size_--;
+    RB_COUNT(removes);
+
+    //every subtree which lost a node is on the path from xParent to the root (y included in case 4)
+    pullUp(xParent);
+
+    //remain the properties of RBTree
+    if(yOriginalColor == BLACK){
+        fixRemove(x, xParent);
+    }
+}
+
+/*
+make a detached node out of one element of a sorted range
+sets take the element as the key, maps take a (key, value) pair
+*/
+RB_TEMPLATE
+template<class Element>
+auto RB_TREE::createFrom(Element&& element) -> Ref{
+    if constexpr (std::is_same_v<Value, Empty>) return store_.create(std::forward<Element>(element));
+    else return store_.create(std::forward<Element>(element).first, std::forward<Element>(element).second);
+}
+
+/*
+build a perfectly balanced subtree of n nodes, next() hands out the nodes in key order
+
+the left part gets (n - 1) / 2 nodes, so all levels above 'redDepth' are full and only the
+last, partly filled level can be deeper. coloring that level red and everything else black
+gives every path the same number of black nodes, without a single fixInsert.
+nodes are created in key order, so with a NodePool neighbours in the tree are neighbours in memory.
+*/
+RB_TEMPLATE
+template<class Next>
+auto RB_TREE::buildSorted(size_type n, int depth, int redDepth, Next& next) -> Ref{
+    if(n == 0) return Ref();
+
+    size_type leftSize = (n - 1) / 2;
+    Ref left = buildSorted(leftSize, depth + 1, redDepth, next);
+    Ref node = next();
+    Ref right = buildSorted(n - 1 - leftSize, depth + 1, redDepth, next);
+
+    setLeft(node, left);
+    setRight(node, right);
+    if(left) setParent(left, node);
+    if(right) setParent(right, node);
+    setColor(node, (depth == redDepth) ? RED : BLACK);
+    pull(node);
+    return node;
+}
+
+//balanced subtree of n nodes, its black height is the number of full levels
+RB_TEMPLATE
+template<class Next>
+auto RB_TREE::buildBalanced(size_type n, Next& next) -> Piece{
+    int fullLevels = 0;
+    while((size_type(2) << fullLevels) - 1 <= n) fullLevels++;
+
+    Ref root = buildSorted(n, 0, fullLevels, next);
+    if(root) setParent(root, Ref());
+    return { root, fullLevels };
+}
+
+//replace the content by a sorted range without duplicates
+RB_TEMPLATE
+template<class InputIt>
+void RB_TREE::assignSorted(InputIt first, InputIt last){
+    //single pass iterators: collect the elements first, the size has to be known
+    if constexpr (!std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>){
+        std::vector<typename std::iterator_traits<InputIt>::value_type> elements(first, last);
+        assignSorted(std::make_move_iterator(elements.begin()), std::make_move_iterator(elements.end()));
+    }
+    else{
+        clear();
+        size_type n = static_cast<size_type>(std::distance(first, last));
+        store_.reserve(n);
+
+        auto next = [&]{ return createFrom(*first++); };
+        setRoot(buildBalanced(n, next));
+        this->size_ = n;
+    }
+}
+
+//key of a batch element: the element itself for sets, .first of a (key, value) pair for maps
+RB_TEMPLATE
+template<class Element>
+auto RB_TREE::elementKey(const Element& element) -> const Key&{
+    if constexpr (isSet) return element;
+    else return element.first;
+}
+
+/*
+lowest ancestor of finger whose subtree can hold key, for key > the finger's key
+every subtree the climb passes already has a lower bound below key (the finger is inside it),
+so only the upper bound matters: a left child's subtree ends at its parent's key.
+a right child's subtree ends where its parent's does, so keep climbing
+*/
+RB_TEMPLATE
+auto RB_TREE::climbFrom(Ref finger, const Key& key) const -> Ref{
+    if(!finger) return root_;
+
+    Ref node = finger;
+    for(Ref parent = parentOf(node); parent; node = parent, parent = parentOf(node)){
+        if(leftOf(parent) == node && comp_(key, keyOf(parent))) return node;
+    }
+    return node;
+}
+
+/*
+the threshold test of the batches. a size left unknown by split() is not counted in full: the walk
+stops after limit + 1 nodes, so a small batch on a big tree keeps its O(m log(n / m))
+*/
+RB_TEMPLATE
+bool RB_TREE::sizeAtMost(size_type limit) const{
+    if(sizeKnown_ || Augment::enabled) return size() <= limit;
+
+    size_type count = 0;
+    for(Ref node = root_ ? findSuccessor(root_) : Ref(); node; node = nextOf(node)){
+        if(++count > limit) return false;
+    }
+    //walked the whole tree, the size is known now
+    size_ = count;
+    sizeKnown_ = true;
+    return true;
+}
+
+RB_TEMPLATE
+template<class InputIt>
+auto RB_TREE::insertBatch(InputIt first, InputIt last) -> size_type{
+    using Element = std::conditional_t<isSet, Key, std::pair<Key, Value>>;
+    std::vector<Element> elements(first, last);
+    if(elements.empty()) return 0;
+
+    //key order, the first of equal keys stays first and survives unique
+    auto less = [&](const Element& a, const Element& b){ return comp_(elementKey(a), elementKey(b)); };
+    std::stable_sort(elements.begin(), elements.end(), less);
+    elements.erase(std::unique(elements.begin(), elements.end(),
+                               [&](const Element& a, const Element& b){ return !less(a, b); }),
+                   elements.end());
+
+    size_type inserted = 0;
+    if(sizeAtMost(elements.size() * batchRebuildRatio)){
+        //merge the old nodes and the new elements in key order, keys already in the tree keep their node
+        std::vector<Ref> nodes;
+        nodes.reserve(size() + elements.size());
+        collectInorder(root_, nodes);
+        store_.reserve(nodes.size() + elements.size());
+
+        std::vector<Ref> merged;
+        merged.reserve(nodes.size() + elements.size());
+        size_type i = 0;
+        for(Element& element : elements){
+            while(i < nodes.size() && comp_(keyOf(nodes[i]), elementKey(element))) merged.push_back(nodes[i++]);
+            if(i < nodes.size() && !comp_(elementKey(element), keyOf(nodes[i]))) continue;     //already in the tree
+
+            merged.push_back(createFrom(std::move(element)));
+            inserted++;
+        }
+        merged.insert(merged.end(), nodes.begin() + i, nodes.end());
+
+        size_type index = 0;
+        auto next = [&]{ return merged[index++]; };
+        setRoot(buildBalanced(merged.size(), next));
+        size_ = merged.size();
+        sizeKnown_ = true;
+        return inserted;
+    }
+
+    Ref finger = Ref();
+    for(Element& element : elements){
+        Ref start = climbFrom(finger, elementKey(element));
+        std::pair<Ref, bool> result;
+        if constexpr (isSet) result = emplaceAt(start, std::move(element));
+        else result = emplaceAt(start, std::move(element.first), std::move(element.second));
+
+        finger = result.first;
+        if(result.second) inserted++;
+    }
+    return inserted;
+}
+
+RB_TEMPLATE
+template<class InputIt>
+auto RB_TREE::removeBatch(InputIt first, InputIt last) -> size_type{
+    std::vector<Key> keys(first, last);
+    if(keys.empty()) return 0;
+
+    std::sort(keys.begin(), keys.end(), comp_);
+    keys.erase(std::unique(keys.begin(), keys.end(), [&](const Key& a, const Key& b){ return !comp_(a, b); }), keys.end());
+
+    size_type removed = 0;
+    if(sizeAtMost(keys.size() * batchRebuildRatio)){
+        //keep every node whose key is not in the batch, relink the survivors
+        std::vector<Ref> nodes;
+        nodes.reserve(size());
+        collectInorder(root_, nodes);
+
+        std::vector<Ref> kept;
+        kept.reserve(nodes.size());
+        size_type k = 0;
+        for(Ref node : nodes){
+            while(k < keys.size() && comp_(keys[k], keyOf(node))) k++;
+            if(k < keys.size() && !comp_(keyOf(node), keys[k])){
+                store_.destroy(node);
+                removed++;
+            }
+            else kept.push_back(node);
+        }
+
+        size_type index = 0;
+        auto next = [&]{ return kept[index++]; };
+        setRoot(buildBalanced(kept.size(), next));
+        size_ = kept.size();
+        sizeKnown_ = true;
+        return removed;
+    }
+
+    //the predecessor of a removed node survives the removal, the next key is greater than it
+    Ref finger = Ref();
+    for(const Key& key : keys){
+        Ref z = climbFrom(finger, key);
+        while(z){
+            if(comp_(keyOf(z), key)) z = rightOf(z);
+            else if(comp_(key, keyOf(z))) z = leftOf(z);
+            else break;
+        }
+        if(!z) continue;
+
+        finger = prevOf(z);
+        removeNode(z);
+        removed++;
+    }
+    return removed;
+}
+
+//the real root of the tree after working on pieces, which may end in a red root
+RB_TEMPLATE
+void RB_TREE::setRoot(Piece piece){
+    this->root_ = piece.root;
+    if(this->root_){
+        setParent(this->root_, Ref());
+        setColor(this->root_, BLACK);
+    }
+}
+
+//black nodes on the leftmost path, every path has the same number
+RB_TEMPLATE
+int RB_TREE::blackHeightOf(Ref node) const{
+    int height = 0;
+    for(; node; node = leftOf(node)){
+        if(colorOf(node) == BLACK) height++;
+    }
+    return height;
+}
+
+//the nodes of a subtree in key order, without recursion
+RB_TEMPLATE
+void RB_TREE::collectInorder(Ref root, std::vector<Ref>& nodes) const{
+    std::vector<Ref> stack;
+    for(Ref node = root; node || !stack.empty(); ){
+        while(node){
+            stack.push_back(node);
+            node = leftOf(node);
+        }
+        node = stack.back();
+        stack.pop_back();
+        nodes.push_back(node);
+        node = rightOf(node);
+    }
+}
+
+/*
+move the subtree 'root' of source's store into this store, source's root_ and size_ are up to the caller
+sharing stores hand the subtree over as it is, otherwise the elements are moved into a new
+balanced subtree and the old nodes are destroyed. count is set to the number of nodes when it
+had to be counted anyway, and left alone otherwise.
+*/
+RB_TEMPLATE
+auto RB_TREE::takeNodes(RBTree& source, Ref root, size_type& count) -> Piece{
+    if(store_.shares(source.store_)) return { root, source.blackHeightOf(root) };
+
+    std::vector<Ref> nodes;
+    source.collectInorder(root, nodes);
+
+    size_type index = 0;
+    auto next = [&]{
+        Node& node = source.store_.get(nodes[index++]);
+        return store_.create(std::move(node.key), std::move(node.value));
+    };
+    Piece piece = buildBalanced(nodes.size(), next);
+
+    for(Ref node : nodes) source.store_.destroy(node);
+    count = nodes.size();
+    return piece;
+}
+
+//copies of the elements of 'other' as a balanced subtree in this store
+RB_TEMPLATE
+auto RB_TREE::copyNodes(const RBTree& other) -> Piece{
+    std::vector<Ref> nodes;
+    other.collectInorder(other.root_, nodes);
+
+    size_type index = 0;
+    auto next = [&]{
+        const Node& node = other.store_.get(nodes[index++]);
+        return store_.create(node.key, node.value);
+    };
+    return buildBalanced(nodes.size(), next);
+}
+
+/*
+join two pieces and a middle node, every key of left < middle < every key of right
+
+a red root is painted black first (always allowed for a root).
+same black height -> middle becomes the black root of both.
+left is higher -> walk down the right spine of left to the first black node with the black height
+of right, hang a red middle there with that node and right as children, fixInsert repairs a
+red parent. right is higher -> the mirror case.
+the cost is O(difference of the black heights + 1)
+*/
+RB_TEMPLATE
+auto RB_TREE::join(Piece left, Ref middle, Piece right) -> Piece{
+    if(left.root && colorOf(left.root) == RED){
+        setColor(left.root, BLACK);
+        left.blackHeight++;
+    }
+    if(right.root && colorOf(right.root) == RED){
+        setColor(right.root, BLACK);
+        right.blackHeight++;
+    }
+
+    //case: same black height, middle is the new root
+    if(left.blackHeight == right.blackHeight){
+        setLeft(middle, left.root);
+        setRight(middle, right.root);
+        if(left.root) setParent(left.root, middle);
+        if(right.root) setParent(right.root, middle);
+        setParent(middle, Ref());
+        setColor(middle, BLACK);
+        pull(middle);
+        return { middle, left.blackHeight + 1 };
+    }
+
+    //case: left is higher, go down its right spine
+    if(left.blackHeight > right.blackHeight){
+        Ref parent = Ref();
+        Ref node = left.root;
+        int height = left.blackHeight;
+        while(height > right.blackHeight || (node && colorOf(node) == RED)){
+            if(colorOf(node) == BLACK) height--;
+            parent = node;
+            node = rightOf(node);
+        }
+
+        setLeft(middle, node);
+        setRight(middle, right.root);
+        if(node) setParent(node, middle);
+        if(right.root) setParent(right.root, middle);
+        setParent(middle, parent);
+        setRight(parent, middle);
+        setColor(middle, RED);
+        pullUp(middle);
+
+        this->root_ = left.root;
+        bool grew = fixInsert(middle);
+        return { this->root_, left.blackHeight + (grew ? 1 : 0) };
+    }
+
+    //case: right is higher, go down its left spine
+    Ref parent = Ref();
+    Ref node = right.root;
+    int height = right.blackHeight;
+    while(height > left.blackHeight || (node && colorOf(node) == RED)){
+        if(colorOf(node) == BLACK) height--;
+        parent = node;
+        node = leftOf(node);
+    }
+
+    setLeft(middle, left.root);
+    setRight(middle, node);
+    if(left.root) setParent(left.root, middle);
+    if(node) setParent(node, middle);
+    setParent(middle, parent);
+    setLeft(parent, middle);
+    setColor(middle, RED);
+    pullUp(middle);
+
+    this->root_ = right.root;
+    bool grew = fixInsert(middle);
+    return { this->root_, right.blackHeight + (grew ? 1 : 0) };
+}
+
+//join without a middle node: the maximum of left becomes the middle
+RB_TEMPLATE
+auto RB_TREE::join2(Piece left, Piece right) -> Piece{
+    if(!left.root) return right;
+    if(!right.root) return left;
+
+    Ref last = Ref();
+    Piece rest = splitLast(left, last);
+    return join(rest, last, right);
+}
+
+//detach the maximum node of a piece, the rest is joined back together on the way up
+RB_TEMPLATE
+auto RB_TREE::splitLast(Piece tree, Ref& last) -> Piece{
+    Ref node = tree.root;
+    int childHeight = tree.blackHeight - ((colorOf(node) == BLACK) ? 1 : 0);
+    Ref left = leftOf(node);
+    Ref right = rightOf(node);
+    if(left) setParent(left, Ref());
+    if(right) setParent(right, Ref());
+
+    if(!right){
+        last = node;
+        return { left, childHeight };
+    }
+
+    Piece rest = splitLast({ right, childHeight }, last);
+    return join({ left, childHeight }, node, rest);
+}
+
+/*
+split a piece by a key, walking down from the root:
+the side we don't go to is joined with the current node onto the matching result
+O(log n), the joins get higher and higher so their costs add up to the height
+*/
+RB_TEMPLATE
+auto RB_TREE::splitAt(Piece tree, const Key& splitKey) -> SplitResult{
+    Ref node = tree.root;
+    if(!node) return { { Ref(), 0 }, Ref(), { Ref(), 0 } };
+
+    int childHeight = tree.blackHeight - ((colorOf(node) == BLACK) ? 1 : 0);
+    Ref left = leftOf(node);
+    Ref right = rightOf(node);
+    if(left) setParent(left, Ref());
+    if(right) setParent(right, Ref());
+
+    //case: split key is in the left subtree
+    if(comp_(splitKey, keyOf(node))){
+        SplitResult result = splitAt({ left, childHeight }, splitKey);
+        result.right = join(result.right, node, { right, childHeight });
+        return result;
+    }
+    //case: split key is in the right subtree
+    if(comp_(keyOf(node), splitKey)){
+        SplitResult result = splitAt({ right, childHeight }, splitKey);
+        result.left = join({ left, childHeight }, node, result.left);
+        return result;
+    }
+    //case: found the split key
+    setLeft(node, Ref());
+    setRight(node, Ref());
+    pull(node);
+    return { { left, childHeight }, node, { right, childHeight } };
+}
+
+/*
+union of two pieces of this store: split a by the root of b, unite the halves, join them with the root
+on equal keys the node of a stays and the one of b is dropped
+*/
+RB_TEMPLATE
+auto RB_TREE::unionPieces(Piece a, Piece b) -> Piece{
+    if(!a.root) return b;
+    if(!b.root) return a;
+
+    Ref middle = b.root;
+    int childHeight = b.blackHeight - ((colorOf(middle) == BLACK) ? 1 : 0);
+    Piece bLeft = { leftOf(middle), childHeight };
+    Piece bRight = { rightOf(middle), childHeight };
+    if(bLeft.root) setParent(bLeft.root, Ref());
+    if(bRight.root) setParent(bRight.root, Ref());
+
+    SplitResult parts = splitAt(a, keyOf(middle));
+    if(parts.found){
+        store_.destroy(middle);
+        this->size_--;
+        middle = parts.found;
+    }
+
+    Piece left = unionPieces(parts.left, bLeft);
+    Piece right = unionPieces(parts.right, bRight);
+    return join(left, middle, right);
+}
+
+//keep the nodes of a whose key is also in the subtree b of other (other is only read)
+RB_TEMPLATE
+auto RB_TREE::intersectPieces(Piece a, const RBTree& other, Ref b) -> Piece{
+    if(!a.root) return a;
+    if(!b){
+        clearTree(a.root);
+        return { Ref(), 0 };
+    }
+
+    SplitResult parts = splitAt(a, other.keyOf(b));
+    Piece left = intersectPieces(parts.left, other, other.leftOf(b));
+    Piece right = intersectPieces(parts.right, other, other.rightOf(b));
+
+    if(parts.found) return join(left, parts.found, right);
+    return join2(left, right);
+}
+
+//drop the nodes of a whose key is in the subtree b of other (other is only read)
+RB_TEMPLATE
+auto RB_TREE::differencePieces(Piece a, const RBTree& other, Ref b) -> Piece{
+    if(!a.root || !b) return a;
+
+    SplitResult parts = splitAt(a, other.keyOf(b));
+    if(parts.found){
+        store_.destroy(parts.found);
+        this->size_--;
+    }
+
+    Piece left = differencePieces(parts.left, other, other.leftOf(b));
+    Piece right = differencePieces(parts.right, other, other.rightOf(b));
+    return join2(left, right);
+}
+
+//append every key of right (all of them greater than the keys here)
+RB_TEMPLATE
+void RB_TREE::join(RBTree&& right){
+    if(this == &right || !right.root_) return;
+
+    size_type rightSize = right.size_;
+    Piece rightPiece = takeNodes(right, right.root_, rightSize);
+    setRoot(join2({ root_, blackHeightOf(root_) }, rightPiece));
+    this->size_ += rightSize;
+    this->sizeKnown_ = this->sizeKnown_ && right.sizeKnown_;
+
+    right.root_ = Ref();
+    right.size_ = 0;
+    right.sizeKnown_ = true;
+}
+
+/*
+keep the keys < splitKey, move the keys >= splitKey to the returned tree
+the result shares the NodePool of this tree (not thread-safe, see the class), so with sharing
+stores nothing is counted, so both sizes are recounted by the next size()
+*/
+RB_TEMPLATE
+auto RB_TREE::split(const Key& splitKey) -> RBTree{
+    RBTree result(*this, store_.sibling());
+    if(!root_) return result;
+
+    SplitResult parts = splitAt({ root_, blackHeightOf(root_) }, splitKey);
+    Piece right = parts.right;
+    if(parts.found) right = join({ Ref(), 0 }, parts.found, right);
+    setRoot(parts.left);
+
+    size_type rightSize = 0;
+    bool counted = !result.store_.shares(store_);
+    result.setRoot(result.takeNodes(*this, right.root, rightSize));
+
+    if(counted){
+        this->size_ -= rightSize;
+        result.size_ = rightSize;
+    }
+    else{
+        this->sizeKnown_ = false;
+        result.sizeKnown_ = false;
+    }
+    return result;
+}
+
+//every key of both trees, the nodes of other are taken over
+RB_TEMPLATE
+void RB_TREE::unionWith(RBTree&& other){
+    if(this == &other || !other.root_) return;
+
+    size_type otherSize = other.size();
+    Piece otherPiece = takeNodes(other, other.root_, otherSize);
+    other.root_ = Ref();
+    other.size_ = 0;
+
+    this->size_ = size() + otherSize;
+    setRoot(unionPieces({ root_, blackHeightOf(root_) }, otherPiece));
+}
+
+//every key of both trees, the elements of other are copied
+RB_TEMPLATE
+void RB_TREE::unionWith(const RBTree& other){
+    if(this == &other || !other.root_) return;
+
+    Piece otherPiece = copyNodes(other);
+    this->size_ = size() + other.size();
+    setRoot(unionPieces({ root_, blackHeightOf(root_) }, otherPiece));
+}
+
+//only the keys which are in both trees
+RB_TEMPLATE
+void RB_TREE::intersectWith(const RBTree& other){
+    if(this == &other) return;
+
+    size();     //make sure the size is known before nodes get dropped
+    setRoot(intersectPieces({ root_, blackHeightOf(root_) }, other, other.root_));
+}
+
+//only the keys which are not in other
+RB_TEMPLATE
+void RB_TREE::differenceWith(const RBTree& other){
+    if(this == &other){
+        clear();
+        return;
+    }
+
+    size();
+    setRoot(differencePieces({ root_, blackHeightOf(root_) }, other, other.root_));
+}
+
+//recompute the augmented data of one node from its children
+RB_TEMPLATE
+void RB_TREE::pull(Ref node){
+    if constexpr (Augment::enabled){
+        store_.get(node).subtreeSize = 1 + countOf(leftOf(node)) + countOf(rightOf(node));
+    }
+}
+
+//recompute node and all of its ancestors, after a node was hung in or cut out below them
+RB_TEMPLATE
+void RB_TREE::pullUp(Ref node){
+    if constexpr (Augment::enabled){
+        for(; node; node = parentOf(node)) pull(node);
+    }
+}
+
+/*
+k-th smallest key (k from 0): compare k with the size of the left subtree,
+go left, stop here, or go right with k reduced by the skipped nodes
+*/
+RB_TEMPLATE
+const Key& RB_TREE::select(size_type k) const requires Augment::enabled{
+    if(k >= countOf(root_)) throw std::out_of_range("rb::RBTree::select: k >= size()");
+
+    Ref node = root_;
+    while(true){
+        size_type leftCount = countOf(leftOf(node));
+        if(k < leftCount) node = leftOf(node);
+        else if(k == leftCount) return keyOf(node);
+        else{
+            k -= leftCount + 1;
+            node = rightOf(node);
+        }
+    }
+}
+
+//number of keys < key (or <= key), adding up the left subtrees we pass on the way down
+RB_TEMPLATE
+auto RB_TREE::countLess(const Key& key, bool orEqual) const -> size_type{
+    size_type count = 0;
+    Ref node = root_;
+    while(node){
+        bool goRight = orEqual ? !comp_(key, keyOf(node)) : comp_(keyOf(node), key);
+        if(goRight){
+            count += countOf(leftOf(node)) + 1;
+            node = rightOf(node);
+        }
+        else node = leftOf(node);
+    }
+    return count;
+}
+
+RB_TEMPLATE
+auto RB_TREE::rank(const Key& key) const -> size_type requires Augment::enabled{
+    return countLess(key, false);
+}
+
+//keys in [lo, hi]: (keys <= hi) - (keys < lo)
+RB_TEMPLATE
+auto RB_TREE::countRange(const Key& lo, const Key& hi) const -> size_type requires Augment::enabled{
+    if(comp_(hi, lo)) return 0;
+    return countLess(hi, true) - countLess(lo, false);
+}
+
+
+#undef RB_TREE
+#undef RB_TEMPLATE
+
+}   //namespace rb
+
+//the common reference of *it and value_type& of the map iterators, read-only like a const_iterator
+template<class Key, class ValueRef, class Value, template<class> class TQual, template<class> class UQual>
+struct std::basic_common_reference<rb::ElementRef<Key, ValueRef>, std::pair<const Key, Value>, TQual, UQual>{
+    using type = std::pair<const Key&, const Value&>;
+};
+template<class Key, class ValueRef, class Value, template<class> class TQual, template<class> class UQual>
+struct std::basic_common_reference<std::pair<const Key, Value>, rb::ElementRef<Key, ValueRef>, TQual, UQual>{
+    using type = std::pair<const Key&, const Value&>;
+};
@@ -0,0 +1,357 @@
+#pragma once
+
+/*
+the AI-written int Red-Black Tree, ai::RBTree, kept to compare against RBTreeImplement.c++
+test/DifferentialTest.c++ checks it against std::set, benchmark/RBTreeBenchmark.c++ measures it
+*/
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Counters.h"
+
+namespace ai {
+
+enum Color { RED, BLACK };
+
+struct Node {
+    int data;
+    bool color;
+    Node *left, *right, *parent;
+
+    Node(int data): data(data), color(RED), left(nullptr), right(nullptr), parent(nullptr) {}
+};
+
+class RBTree {
+private:
+    Node* root;
+
+    void rotateLeft(Node*& node) {
+        Node* rightChild = node->right;
+        node->right = rightChild->left;
+        if (rightChild->left != nullptr)
+            rightChild->left->parent = node;
+        rightChild->parent = node->parent;
+
+        if (node->parent == nullptr)
+            root = rightChild;
+        else if (node == node->parent->left)
+            node->parent->left = rightChild;
+        else
+            node->parent->right = rightChild;
+
+        rightChild->left = node;
+        node->parent = rightChild;
+    }
+
+    void rotateRight(Node*& node) {
+        Node* leftChild = node->left;
+        node->left = leftChild->right;
+        if (leftChild->right != nullptr)
+            leftChild->right->parent = node;
+        leftChild->parent = node->parent;
+
+        if (node->parent == nullptr)
+            root = leftChild;
+        else if (node == node->parent->right)
+            node->parent->right = leftChild;
+        else
+            node->parent->left = leftChild;
+
+        leftChild->right = node;
+        node->parent = leftChild;
+    }
+
+    void fixInsert(Node*& node) {
+        Node* parent = nullptr;
+        Node* grandparent = nullptr;
+
+        while (node != root && node->color == RED && node->parent->color == RED) {
+            RB_COUNT(insertFixupLoops);
+            parent = node->parent;
+            grandparent = parent->parent;
+
+            // case A: parent is left child
+            if (parent == grandparent->left) {
+                Node* uncle = grandparent->right;
+
+                if (uncle != nullptr && uncle->color == RED) {
+                    // Case 1: uncle is RED → recolor
+                    RB_COUNT(insertCase1);
+                    grandparent->color = RED;
+                    parent->color = BLACK;
+                    uncle->color = BLACK;
+                    node = grandparent;
+                }
+                else {
+                    // Case 2: uncle is BLACK
+                    if (node == parent->right) {
+                        RB_COUNT(insertCase2);
+                        RB_COUNT(insertRotations);
+                        rotateLeft(parent);
+                        node = parent;
+                        parent = node->parent;
+                    }
+                    RB_COUNT(insertCase3);
+                    RB_COUNT(insertRotations);
+                    rotateRight(grandparent);
+                    std::swap(parent->color, grandparent->color);
+                    node = parent;
+                }
+            }
+            else {
+                // case B: parent is right child
+                Node* uncle = grandparent->left;
+
+                if (uncle != nullptr && uncle->color == RED) {
+                    // Mirror Case 1
+                    RB_COUNT(insertCase1);
+                    grandparent->color = RED;
+                    parent->color = BLACK;
+                    uncle->color = BLACK;
+                    node = grandparent;
+                }
+                else {
+                    if (node == parent->left) {
+                        RB_COUNT(insertCase2);
+                        RB_COUNT(insertRotations);
+                        rotateRight(parent);
+                        node = parent;
+                        parent = node->parent;
+                    }
+                    RB_COUNT(insertCase3);
+                    RB_COUNT(insertRotations);
+                    rotateLeft(grandparent);
+                    std::swap(parent->color, grandparent->color);
+                    node = parent;
+                }
+            }
+        }
+        root->color = BLACK;
+    }
+
+    // node may be nullptr (a removed black leaf), so its parent is passed along
+    void fixDelete(Node* node, Node* parent) {
+        Node* sibling = nullptr;
+        while (node != root && (node == nullptr || node->color == BLACK)) {
+            RB_COUNT(removeFixupLoops);
+            if (node == parent->left) {
+                sibling = parent->right;
+                if (sibling->color == RED) {
+                    RB_COUNT(removeCase1);
+                    RB_COUNT(removeRotations);
+                    sibling->color = BLACK;
+                    parent->color = RED;
+                    rotateLeft(parent);
+                    sibling = parent->right;
+                }
+                if ((sibling->left == nullptr || sibling->left->color == BLACK) &&
+                    (sibling->right == nullptr || sibling->right->color == BLACK)) {
+                    RB_COUNT(removeCase2);
+                    sibling->color = RED;
+                    node = parent;
+                    parent = node->parent;
+                } else {
+                    if (sibling->right == nullptr || sibling->right->color == BLACK) {
+                        RB_COUNT(removeCase3);
+                        RB_COUNT(removeRotations);
+                        if (sibling->left)
+                            sibling->left->color = BLACK;
+                        sibling->color = RED;
+                        rotateRight(sibling);
+                        sibling = parent->right;
+                    }
+                    RB_COUNT(removeCase4);
+                    RB_COUNT(removeRotations);
+                    sibling->color = parent->color;
+                    parent->color = BLACK;
+                    if (sibling->right)
+                        sibling->right->color = BLACK;
+                    rotateLeft(parent);
+                    node = root;
+                }
+            }
+            else {
+                sibling = parent->left;
+                if (sibling->color == RED) {
+                    RB_COUNT(removeCase1);
+                    RB_COUNT(removeRotations);
+                    sibling->color = BLACK;
+                    parent->color = RED;
+                    rotateRight(parent);
+                    sibling = parent->left;
+                }
+                if ((sibling->left == nullptr || sibling->left->color == BLACK) &&
+                    (sibling->right == nullptr || sibling->right->color == BLACK)) {
+                    RB_COUNT(removeCase2);
+                    sibling->color = RED;
+                    node = parent;
+                    parent = node->parent;
+                } else {
+                    if (sibling->left == nullptr || sibling->left->color == BLACK) {
+                        RB_COUNT(removeCase3);
+                        RB_COUNT(removeRotations);
+                        if (sibling->right)
+                            sibling->right->color = BLACK;
+                        sibling->color = RED;
+                        rotateLeft(sibling);
+                        sibling = parent->left;
+                    }
+                    RB_COUNT(removeCase4);
+                    RB_COUNT(removeRotations);
+                    sibling->color = parent->color;
+                    parent->color = BLACK;
+                    if (sibling->left)
+                        sibling->left->color = BLACK;
+                    rotateRight(parent);
+                    node = root;
+                }
+            }
+        }
+        if (node) node->color = BLACK;
+    }
+
+    void transplant(Node* u, Node* v) {
+        if (u->parent == nullptr) root = v;
+        else if (u == u->parent->left) u->parent->left = v;
+        else u->parent->right = v;
+        if (v != nullptr) v->parent = u->parent;
+    }
+
+    Node* minValue(Node* node) {
+        while (node->left != nullptr)
+            node = node->left;
+        return node;
+    }
+
+    void deleteNode(int key) {
+        Node* z = root;
+        Node* x, *y;
+        Node* xParent;
+        while (z != nullptr) {
+            if (z->data == key) break;
+            if (key < z->data) z = z->left;
+            else z = z->right;
+        }
+
+        if (z == nullptr) return;
+
+        y = z;
+        bool yOriginalColor = y->color;
+        if (z->left == nullptr) {
+            x = z->right;
+            xParent = z->parent;
+            transplant(z, z->right);
+        }
+        else if (z->right == nullptr) {
+            x = z->left;
+            xParent = z->parent;
+            transplant(z, z->left);
+        }
+        else {
+            y = minValue(z->right);
+            yOriginalColor = y->color;
+            x = y->right;
+            if (y->parent == z) {
+                if (x) x->parent = y;
+                xParent = y;
+            } else {
+                xParent = y->parent;
+                transplant(y, y->right);
+                y->right = z->right;
+                y->right->parent = y;
+            }
+            transplant(z, y);
+            y->left = z->left;
+            y->left->parent = y;
+            y->color = z->color;
+        }
+
+        delete z;
+        RB_COUNT(removes);
+
+        if (yOriginalColor == BLACK)
+            fixDelete(x, xParent);
+    }
+
+    void clear(Node* node) {
+        if (node == nullptr) return;
+        clear(node->left);
+        clear(node->right);
+        delete node;
+    }
+
+    void printTree(Node* root, std::string indent, bool last) const {
+        if (root != nullptr) {
+            std::cout << indent;
+            if (last) {
+                std::cout << "R----";
+                indent += "     ";
+            } else {
+                std::cout << "L----";
+                indent += "|    ";
+            }
+
+            std::string color = root->color == RED ? "RED" : "BLACK";
+            std::cout << root->data << "(" << color << ")" << std::endl;
+            printTree(root->left, indent, false);
+            printTree(root->right, indent, true);
+        }
+    }
+
+    void printTreePreorder(Node* node) const;
+    int blackHeight(Node* node, bool& isViolated) const;
+    void collectKeys(Node* node, std::vector<int>& keys) const;
+    int heightOf(Node* node) const;
+public:
+    RBTree() : root(nullptr) {}
+    ~RBTree() { clear(root); }
+    RBTree(const RBTree&) = delete;
+    RBTree& operator=(const RBTree&) = delete;
+
+    void insert(int data) {
+        Node* y = nullptr;
+        Node* x = root;
+
+        while (x != nullptr) {
+            y = x;
+            if (data < x->data)
+                x = x->left;
+            else if(data > x->data)
+                x = x->right;
+            else
+                return;
+        }
+
+        Node* node = new Node(data);
+        RB_COUNT(inserts);
+
+        node->parent = y;
+        if (y == nullptr)
+            root = node;
+        else if (node->data < y->data)
+            y->left = node;
+        else
+            y->right = node;
+
+        fixInsert(node);
+    }
+
+    void remove(int data) {
+        deleteNode(data);
+    }
+
+    void print() const {
+        printTreePreorder(this->root);
+    }
+
+    // same checks and queries as implement::RBTree, for the tests and benchmarks
+    bool isValidRBTree() const;
+    bool contains(int data) const;
+    std::vector<int> keys() const;
+    int height() const;
+};
+
+}   // namespace ai
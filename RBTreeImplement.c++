@@ -3,102 +3,14 @@ Built with love for data structures and competitive programming.
 Join us at PDAO — we're hiring team members to run the next great contest!
 */
 
+#include <algorithm>
 #include <iostream>
-using namespace std;
 
-//each node in the Red-Black Tree is either RED or BLACK
-enum Color { RED, BLACK };
-
-//all nodes records its data, color, left node, right node, parent node
-struct Node{
-    Color color;
-    int data;
-    Node* left;
-    Node* right;
-    Node* parent;
-    // Constructor: new nodes are red by default, and their children are initially nullptr.
-    Node(const int newData, Node* newParent = nullptr) 
-    : color(RED), data(newData), left(nullptr), right(nullptr), parent(newParent) {}
-};
+#include "Counters.h"
+#include "RBTreeImplement.h"
+using namespace std;
 
-/*
-Red-Black Tree Rule
-1.the color of each node is either red or black
-2.the color of the root is always black
-3.the color of the leaves(nullptr) are considered black
-4.no two consecutive red nodes are allowed (red nodes should not have red child)
-5.Every path from a node to its descendant leaves must contain the same number of black nodes
-*/
-class RBTree{
-    private:
-        //root of the tree
-        Node* root_;
-
-        //some operation make the insert and remove function easier
-        void rightRotation(Node* node);        //right rotations used during balancing
-        void leftRotation(Node* node);         //left rotations used during balancing
-        void replace(Node* a, Node* b);         //replace node 'a' with node 'b' in the tree structure (but not deleting a)
-        Node* findSuccessor(Node* node);        //find the in-order successor (minimum in right subtree)
-
-        //fix some problem and remain the property of BRTree, when we insert or remove nodes
-        void fixInsert(Node* node);
-        void fixRemove(Node* node, Node* parent);
-
-        //recursive helpers for cleanup, printing, dfs to check the number of black nodes
-        void clearTree(Node* node);
-        void printTreeInorder(Node* node) const;
-        void printTreePreorder(Node* node) const;
-        int dfsCheckBRTree(Node* node, bool& isViolated) const;
-
-    public:
-        //constructor, destructor, print, checkBRTree interface
-        RBTree();
-        ~RBTree();
-        void print() const;
-        bool isValidRBTree() const;
-
-        //insert, remove interface and implement
-        void insert(const int newData);
-        void remove(const int newData);
-};
-
-//some simple test
-int main(){
-    int input;
-    cin >> input;
-
-    RBTree tree;
-    tree.isValidRBTree();
-    for(int i = 0; i < 10; i++){
-        cout << "insert: " << i * 10 << endl;
-        tree.insert(i * 10);
-        tree.print();
-        tree.isValidRBTree();
-    }
-    for(int i = 5; i >= 0; i--){
-        cout << "remove: " << i * 10 << endl;
-        tree.remove(i * 10);
-        tree.print();
-        tree.isValidRBTree();
-    }
-    cout << "remove: " << 80 << endl;
-    tree.remove(80);
-    tree.print();
-    tree.isValidRBTree();
-    cout << "remove: " << 90 << endl;
-    tree.remove(90);
-    tree.print();
-    tree.isValidRBTree();
-    cout << "remove: " << 70 << endl;
-    tree.remove(70);
-    tree.print();
-    tree.isValidRBTree();
-    cout << "remove: " << 60 << endl;
-    tree.remove(60);
-    tree.print();
-    tree.isValidRBTree();
-    return 0;
-}
+namespace implement {
 
 //just set the root initial condition, nullptr
 RBTree::RBTree() : root_(nullptr) {}
@@ -122,12 +34,7 @@ bool RBTree::isValidRBTree() const {
     bool isViolated = 0;
     dfsCheckBRTree(this->root_, isViolated);
 
-    if(!isViolated) return true;
-
-    for(int i = 0; i < 10; i++){
-        cout << "NOOOOOOOOOOOOOOOO" << endl;
-    }
-    return false;
+    return !isViolated;
 }
 
 //dfs to check if the tree BRTree
@@ -305,7 +212,8 @@ case 3, uncle node is black & node is in LL or RR path of grandparent -> adjust
 void RBTree::fixInsert(Node* node){  
 
     //node is red -> node's parent exist -> check if node and node's parent are consecutive red nodes
-    while(node != this->root_ && node && node->color == RED && node->parent->color == RED){ 
+    while(node != this->root_ && node && node->color == RED && node->parent->color == RED){
+        RB_COUNT(insertFixupLoops);
 
         Node* parent = node->parent;
         Node* grandparent = parent->parent;         //grand parent should exist, because node->parent is red
@@ -316,6 +224,7 @@ void RBTree::fixInsert(Node* node){
 
             //case 1, uncle is red
             if(uncle && uncle->color == RED){
+                RB_COUNT(insertCase1);
                 parent->color = BLACK;
                 uncle->color = BLACK;
                 grandparent->color = RED;
@@ -327,12 +236,16 @@ void RBTree::fixInsert(Node* node){
 
             //check if case 2, node in LR of grandparent
             if(parent->right == node){
+                RB_COUNT(insertCase2);
+                RB_COUNT(insertRotations);
                 leftRotation(parent);
                 node = parent;
                 parent = node->parent;
             }
             
             //deal with case 3, node in LL of grandparent
+            RB_COUNT(insertCase3);
+            RB_COUNT(insertRotations);
             grandparent->color = RED;
             parent->color = BLACK;
             rightRotation(grandparent);
@@ -346,6 +259,7 @@ void RBTree::fixInsert(Node* node){
 
             //case 1, uncle is red
             if(uncle && uncle->color == RED){
+                RB_COUNT(insertCase1);
                 parent->color = BLACK;
                 uncle->color = BLACK;
                 grandparent->color = RED;
@@ -357,12 +271,16 @@ void RBTree::fixInsert(Node* node){
 
             //check if case 2, node in RL of grandparent
             if(parent->left == node){
+                RB_COUNT(insertCase2);
+                RB_COUNT(insertRotations);
                 rightRotation(parent);
                 node = parent;
                 parent = node->parent;
             }
             
             //deal with case 3, node in RR of grandparent
+            RB_COUNT(insertCase3);
+            RB_COUNT(insertRotations);
             grandparent->color = RED;
             parent->color = BLACK;
             leftRotation(grandparent);
@@ -399,6 +317,7 @@ void RBTree::insert(const int newData){
     else prev->left = newNode;
 
     //remain RBTree properties
+    RB_COUNT(inserts);
     fixInsert(newNode);
 }
 
@@ -420,12 +339,15 @@ Last, set the node black wherever the node is
 void RBTree::fixRemove(Node* node, Node* parent){
 
     while((!node || node->color == BLACK) && node != root_){       //loop when the node's color is black
+        RB_COUNT(removeFixupLoops);
         //case: node is in the left side of parent
         if(parent->left == node){
             Node* sibling = parent->right;      //sibling is in the right side of parent
             
             //case 1, sibling is red
             if(sibling && sibling->color == RED){
+                RB_COUNT(removeCase1);
+                RB_COUNT(removeRotations);
                 sibling->color = BLACK;
                 parent->color = RED;
                 leftRotation(parent);
@@ -440,6 +362,7 @@ void RBTree::fixRemove(Node* node, Node* parent){
             //case 2, sibling is black and both of its children are black
             if((!siblingLeft || siblingLeft->color == BLACK) 
             && (!siblingRight || siblingRight->color == BLACK)){
+                RB_COUNT(removeCase2);
                 if(sibling) sibling->color = RED;
 
                 node = parent;
@@ -448,7 +371,9 @@ void RBTree::fixRemove(Node* node, Node* parent){
             }
 
             //case 3, sibling is black and its left child is red
-            if(!siblingRight && siblingRight->color == BLACK){
+            if(!siblingRight || siblingRight->color == BLACK){
+                RB_COUNT(removeCase3);
+                RB_COUNT(removeRotations);
                 if(siblingLeft) siblingLeft->color = BLACK;
                 if(sibling) sibling->color = RED;
                 rightRotation(sibling);
@@ -460,6 +385,8 @@ void RBTree::fixRemove(Node* node, Node* parent){
             siblingRight = (sibling) ? sibling->right : nullptr;
 
             //csae 4, sibling is black and its right child is red
+            RB_COUNT(removeCase4);
+            RB_COUNT(removeRotations);
             if(sibling) sibling->color = parent->color;
             parent->color = BLACK;
             if(siblingRight) siblingRight->color = BLACK;
@@ -472,11 +399,13 @@ void RBTree::fixRemove(Node* node, Node* parent){
             
             //case 1, sibling is red
             if(sibling && sibling->color == RED){
-                if(sibling) sibling->color = BLACK;
+                RB_COUNT(removeCase1);
+                RB_COUNT(removeRotations);
+                sibling->color = BLACK;
                 parent->color = RED;
                 rightRotation(parent);
 
-                sibling = parent->right;
+                sibling = parent->left;
             }
 
             //we aren't sure whether sibling exist
@@ -486,6 +415,7 @@ void RBTree::fixRemove(Node* node, Node* parent){
             //case 2, sibling is black and both of its children are black
             if((!siblingLeft || siblingLeft->color == BLACK) 
             && (!siblingRight || siblingRight->color == BLACK)){
+                RB_COUNT(removeCase2);
                 if(sibling) sibling->color = RED;
 
                 node = parent;
@@ -494,7 +424,9 @@ void RBTree::fixRemove(Node* node, Node* parent){
             }
 
             //case 3, sibling is black and its right child is red
-            if(!siblingLeft && siblingLeft->color == BLACK){
+            if(!siblingLeft || siblingLeft->color == BLACK){
+                RB_COUNT(removeCase3);
+                RB_COUNT(removeRotations);
                 if(siblingRight) siblingRight->color = BLACK;
                 if(sibling) sibling->color = RED;
                 leftRotation(sibling);
@@ -506,6 +438,8 @@ void RBTree::fixRemove(Node* node, Node* parent){
             siblingRight = (sibling) ? sibling->right : nullptr;
 
             //case 4, sibling is black and its left child is red
+            RB_COUNT(removeCase4);
+            RB_COUNT(removeRotations);
             if(sibling) sibling->color = parent->color;
             parent->color = BLACK;
             if(siblingLeft) siblingLeft->color = BLACK;
@@ -600,6 +534,7 @@ void RBTree::remove(const int newData){
     }
 
     delete z;
+    RB_COUNT(removes);
 
     //remain the properties of RBTree
     if(yOriginalColor == BLACK){
@@ -607,3 +542,39 @@ void RBTree::remove(const int newData){
     }
 
 }
+
+//lookup like BST
+bool RBTree::contains(const int data) const{
+    Node* node = this->root_;
+    while(node != nullptr){
+        if(data > node->data) node = node->right;
+        else if(data < node->data) node = node->left;
+        else return true;
+    }
+    return false;
+}
+
+//all keys in order
+vector<int> RBTree::keys() const{
+    vector<int> keys;
+    collectKeys(this->root_, keys);
+    return keys;
+}
+
+//in-order traversal: left -> node -> right
+void RBTree::collectKeys(Node* node, vector<int>& keys) const{
+    if(node == nullptr) return;
+    collectKeys(node->left, keys);
+    keys.push_back(node->data);
+    collectKeys(node->right, keys);
+}
+
+//number of nodes on the longest path from the root to a leaf
+int RBTree::height() const {return heightOf(this->root_);}
+
+int RBTree::heightOf(Node* node) const{
+    if(node == nullptr) return 0;
+    return 1 + max(heightOf(node->left), heightOf(node->right));
+}
+
+}   //namespace implement
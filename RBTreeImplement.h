@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+the original int Red-Black Tree, implement::RBTree, defined in RBTreeImplement.c++
+RBTree.h is its templated version, test/DifferentialTest.c++ checks both against std::set
+and benchmark/RBTreeBenchmark.c++ measures both
+*/
+
+#include <vector>
+
+namespace implement {
+
+//each node in the Red-Black Tree is either RED or BLACK
+enum Color { RED, BLACK };
+
+//all nodes records its data, color, left node, right node, parent node
+struct Node{
+    Color color;
+    int data;
+    Node* left;
+    Node* right;
+    Node* parent;
+    // Constructor: new nodes are red by default, and their children are initially nullptr.
+    Node(const int newData, Node* newParent = nullptr)
+    : color(RED), data(newData), left(nullptr), right(nullptr), parent(newParent) {}
+};
+
+/*
+Red-Black Tree Rule
+1.the color of each node is either red or black
+2.the color of the root is always black
+3.the color of the leaves(nullptr) are considered black
+4.no two consecutive red nodes are allowed (red nodes should not have red child)
+5.Every path from a node to its descendant leaves must contain the same number of black nodes
+*/
+class RBTree{
+    private:
+        //root of the tree
+        Node* root_;
+
+        //some operation make the insert and remove function easier
+        void rightRotation(Node* node);        //right rotations used during balancing
+        void leftRotation(Node* node);         //left rotations used during balancing
+        void replace(Node* a, Node* b);         //replace node 'a' with node 'b' in the tree structure (but not deleting a)
+        Node* findSuccessor(Node* node);        //find the in-order successor (minimum in right subtree)
+
+        //fix some problem and remain the property of BRTree, when we insert or remove nodes
+        void fixInsert(Node* node);
+        void fixRemove(Node* node, Node* parent);
+
+        //recursive helpers for cleanup, printing, dfs to check the number of black nodes
+        void clearTree(Node* node);
+        void printTreeInorder(Node* node) const;
+        void printTreePreorder(Node* node) const;
+        int dfsCheckBRTree(Node* node, bool& isViolated) const;
+        void collectKeys(Node* node, std::vector<int>& keys) const;
+        int heightOf(Node* node) const;
+
+    public:
+        //constructor, destructor, print, checkBRTree interface
+        RBTree();
+        ~RBTree();
+        RBTree(const RBTree&) = delete;
+        RBTree& operator=(const RBTree&) = delete;
+        void print() const;
+        bool isValidRBTree() const;
+
+        //insert, remove interface and implement
+        void insert(const int newData);
+        void remove(const int newData);
+
+        //queries for the tests and benchmarks: lookup, keys in order, nodes on the longest path
+        bool contains(const int data) const;
+        std::vector<int> keys() const;
+        int height() const;
+};
+
+}   //namespace implement
@@ -0,0 +1,155 @@
+#pragma once
+
+/*
+binary file format of rb::RBTree::save() / load() and rb::MappedRBTree
+
+    FileHeader              64 bytes
+    FileRecord[count]       at recordOffset, the nodes in key order
+
+a record holds the key, the value, and the tree shape: 1-based record indices of the left and right
+child (0 = none) and the color in bit 0 of rightColor, the same packing as IndexLayout.
+with the nodes in key order, load() creates them one after another and relinks them as they were,
+no comparison and no fixInsert, and a mapped file can be searched as it is: the indices are the
+offsets, there is nothing to deserialize.
+keys and values are written as raw bytes, so they have to be trivially copyable, and the file
+is only read back on a machine with the same byte order and type sizes (checked in the header).
+checksum() covers the records, it catches damaged or truncated files, not forged ones.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "NodeLayout.h"
+
+namespace rb {
+
+struct FileHeader{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;        //byteOrderMark as written, reads differently on the other byte order
+    std::uint32_t recordSize;
+    std::uint32_t keySize;
+    std::uint32_t valueSize;
+    std::uint32_t root;             //record index of the root, 0 for an empty tree
+    std::uint64_t count;
+    std::uint64_t recordOffset;
+    std::uint64_t checksum;
+    char reserved[8];
+
+    static constexpr char fileMagic[8] = { 'R', 'B', 'T', 'R', 'E', 'E', '\0', '\0' };
+    static constexpr std::uint32_t currentVersion = 1;
+    static constexpr std::uint32_t byteOrderMark = 0x01020304;
+};
+static_assert(sizeof(FileHeader) == 64, "rb::FileHeader has to stay 64 bytes");
+
+template<class Key, class Value>
+struct FileRecord{
+    std::uint32_t left;
+    std::uint32_t rightColor;
+    Key key;
+    [[no_unique_address]] Value value;
+
+    std::uint32_t right() const { return rightColor >> 1; }
+    Color color() const { return static_cast<Color>(rightColor & 1); }
+};
+
+//the most records 32-bit indices with a color bit can address
+inline constexpr std::uint64_t maxFileRecords = (std::uint64_t(1) << 31) - 1;
+
+/*
+64-bit checksum, four independent multiply-xor lanes over 8-byte words so it runs at memory speed
+(a byte-wise hash would dominate the load time)
+*/
+inline std::uint64_t checksum(const void* data, std::size_t bytes){
+    constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87ull;
+    constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+    auto mix = [](std::uint64_t lane, std::uint64_t word){
+        lane ^= word * prime2;
+        lane = (lane << 31) | (lane >> 33);
+        return lane * prime1;
+    };
+
+    const unsigned char* bytesIn = static_cast<const unsigned char*>(data);
+    std::uint64_t lanes[4] = { prime1, prime2, ~prime1, ~prime2 };
+    std::size_t offset = 0;
+    for(; offset + 32 <= bytes; offset += 32){
+        for(int lane = 0; lane < 4; lane++){
+            std::uint64_t word;
+            std::memcpy(&word, bytesIn + offset + 8 * lane, 8);
+            lanes[lane] = mix(lanes[lane], word);
+        }
+    }
+
+    std::uint64_t hash = bytes;
+    for(std::uint64_t lane : lanes) hash = mix(hash, lane);
+    for(; offset < bytes; offset++) hash = mix(hash, bytesIn[offset]);
+    hash ^= hash >> 33;
+    hash *= prime1;
+    return hash ^ (hash >> 29);
+}
+
+template<class Key, class Value>
+FileHeader makeFileHeader(std::uint64_t count, std::uint32_t root, std::uint64_t recordChecksum){
+    static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>,
+                  "rb::RBTree files store keys and values as raw bytes, they must be trivially copyable");
+
+    FileHeader header{};
+    std::memcpy(header.magic, FileHeader::fileMagic, sizeof(header.magic));
+    header.version = FileHeader::currentVersion;
+    header.byteOrder = FileHeader::byteOrderMark;
+    header.recordSize = sizeof(FileRecord<Key, Value>);
+    header.keySize = sizeof(Key);
+    header.valueSize = std::is_empty_v<Value> ? 0 : sizeof(Value);
+    header.root = root;
+    header.count = count;
+    header.recordOffset = sizeof(FileHeader);
+    header.checksum = recordChecksum;
+    return header;
+}
+
+//throws std::runtime_error unless the header fits Key / Value and a file of fileSize bytes
+template<class Key, class Value>
+void checkFileHeader(const FileHeader& header, std::uint64_t fileSize){
+    FileHeader expected = makeFileHeader<Key, Value>(0, 0, 0);
+
+    if(std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) throw std::runtime_error("rb: not an RBTree file");
+    if(header.version != expected.version) throw std::runtime_error("rb: unsupported RBTree file version " + std::to_string(header.version));
+    if(header.byteOrder != expected.byteOrder) throw std::runtime_error("rb: RBTree file written with another byte order");
+    if(header.recordSize != expected.recordSize || header.keySize != expected.keySize || header.valueSize != expected.valueSize)
+        throw std::runtime_error("rb: RBTree file written for other key / value types");
+    if(header.count > maxFileRecords || header.root > header.count || (header.count && !header.root))
+        throw std::runtime_error("rb: corrupt RBTree file header");
+    if(header.recordOffset % alignof(FileRecord<Key, Value>) != 0 || header.recordOffset < sizeof(FileHeader)
+       || fileSize < header.recordOffset || (fileSize - header.recordOffset) / header.recordSize < header.count)
+        throw std::runtime_error("rb: truncated RBTree file");
+}
+
+/*
+true when the records form one binary tree whose in-order walk visits 1, 2, .. count,
+which makes the links safe to follow (no cycles, nothing shared, nothing out of range)
+*/
+template<class Key, class Value>
+bool checkFileShape(const FileRecord<Key, Value>* records, std::uint64_t count, std::uint32_t root){
+    //records[index - 1] is the record 'index'
+    std::uint32_t stack[maxTreeDepth];
+    int top = 0;
+    std::uint64_t expected = 1;
+
+    for(std::uint32_t index = root; index || top > 0; ){
+        while(index){
+            if(index > count || top == maxTreeDepth) return false;
+            stack[top++] = index;
+            index = records[index - 1].left;
+        }
+        index = stack[--top];
+        if(index != expected++) return false;
+        index = records[index - 1].right();
+    }
+    return expected == count + 1;
+}
+
+}   //namespace rb
@@ -0,0 +1,128 @@
+/*
+node pool vs per-node new/delete
+
+builds the same random workloads on
+    rb::RBSet<int>                                  (default rb::NodePool)
+    rb::RBSet<int, std::less<int>, std::allocator>  (one new/delete per node, like RBTreeImplement.c++)
+and reports time and how many times the global allocator was called.
+
+build: g++ -O2 -std=c++20 -I. benchmark/AllocatorBenchmark.c++ -o output/AllocatorBenchmark
+run:   ./output/AllocatorBenchmark [number of keys, default 1000000]
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RBTree.h"
+using namespace std;
+
+//count every call into the global allocator
+static size_t allocationCount = 0;
+
+void* operator new(size_t size){
+    allocationCount++;
+    if(void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void* operator new(size_t size, align_val_t align){
+    allocationCount++;
+    size_t alignment = static_cast<size_t>(align);
+    if(void* p = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { free(p); }
+
+struct Result{
+    double seconds;
+    size_t allocations;
+};
+
+//time one phase and count its allocations
+template<class Function>
+Result measure(Function&& function){
+    size_t before = allocationCount;
+    auto start = chrono::steady_clock::now();
+    function();
+    auto end = chrono::steady_clock::now();
+    return { chrono::duration<double>(end - start).count(), allocationCount - before };
+}
+
+void report(const string& tree, const string& phase, size_t ops, const Result& result){
+    cout << left << setw(14) << tree << setw(18) << phase
+         << right << setw(10) << fixed << setprecision(1) << result.seconds * 1000 << " ms"
+         << setw(10) << setprecision(2) << ops / result.seconds / 1e6 << " Mops/s"
+         << setw(12) << result.allocations << " allocations" << endl;
+}
+
+/*
+phases:
+insert  n random keys into an empty tree
+churn   n rounds of (remove a present key, insert a new key), the size stays at n
+remove  remove every key again
+destroy fill the tree again and destroy it
+*/
+template<class Tree>
+void runWorkload(const string& name, const vector<int>& keys, const vector<int>& churnKeys){
+    size_t n = keys.size();
+    {
+        Tree tree;
+        report(name, "insert", n, measure([&]{ for(int key : keys) tree.insert(key); }));
+
+        report(name, "churn", 2 * n, measure([&]{
+            for(size_t i = 0; i < n; i++){
+                tree.remove(keys[i]);
+                tree.insert(churnKeys[i]);
+            }
+        }));
+
+        report(name, "remove", n, measure([&]{ for(int key : churnKeys) tree.remove(key); }));
+        if(!tree.isValidRBTree() || !tree.empty()) cout << "invalid tree after " << name << endl;
+    }
+
+    auto tree = make_unique<Tree>();
+    for(int key : keys) tree->insert(key);
+    report(name, "destroy", n, measure([&]{ tree.reset(); }));
+}
+
+//move-only values: emplace a unique_ptr payload, churn, destroy
+template<class Map>
+void runMoveOnly(const string& name, const vector<int>& keys){
+    size_t n = keys.size();
+    Map map;
+    report(name, "emplace", n, measure([&]{
+        for(int key : keys) map.emplace(key, make_unique<int>(key));
+    }));
+    report(name, "remove", n, measure([&]{ for(int key : keys) map.remove(key); }));
+}
+
+int main(int argc, char* argv[]){
+    size_t n = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    //distinct random keys, churn keys are disjoint from the first batch
+    mt19937 random(12345);
+    vector<int> all(2 * n);
+    for(size_t i = 0; i < all.size(); i++) all[i] = static_cast<int>(i);
+    shuffle(all.begin(), all.end(), random);
+    vector<int> keys(all.begin(), all.begin() + n);
+    vector<int> churnKeys(all.begin() + n, all.end());
+
+    cout << "keys: " << n << ", pool slab holds "
+         << rb::NodePool<rb::RBSet<int>::Node>::nodesPerSlab() << " nodes" << endl;
+
+    runWorkload<rb::RBSet<int>>("NodePool", keys, churnKeys);
+    runWorkload<rb::RBSet<int, less<int>, allocator<int>>>("new/delete", keys, churnKeys);
+
+    runMoveOnly<rb::RBMap<int, unique_ptr<int>>>("NodePool", keys);
+    runMoveOnly<rb::RBMap<int, unique_ptr<int>, less<int>, allocator<int>>>("new/delete", keys);
+    return 0;
+}
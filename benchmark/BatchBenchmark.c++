@@ -0,0 +1,98 @@
+/*
+insertBatch / removeBatch against a loop of single insert() / remove() calls
+
+the tree holds the n even keys 0, 2, .. 2n - 2. a batch of m keys is applied to a fresh copy:
+insert   m new odd keys
+remove   m of the even keys
+each in two shapes: "random" keys spread over the whole tree, "clustered" keys from one
+contiguous stretch (where finger search only climbs a few levels per key).
+batches of at least n / batchRebuildRatio keys take the merge-and-rebuild path
+
+build: g++ -O2 -std=c++20 -I. benchmark/BatchBenchmark.c++ -o output/BatchBenchmark
+run:   ./output/BatchBenchmark [n, default 1000000]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RBTree.h"
+using namespace std;
+
+using Tree = rb::RBSet<int>;
+
+template<class Function>
+double seconds(Function&& function){
+    auto start = chrono::steady_clock::now();
+    function();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+//time one batch against one loop, each on its own fresh tree
+void compare(const string& what, const vector<int>& base, const vector<int>& batch, bool insert){
+    double loopTime, batchTime;
+    {
+        Tree tree(rb::sortedUnique, base.begin(), base.end());
+        loopTime = seconds([&]{
+            for(int key : batch){
+                if(insert) tree.insert(key);
+                else tree.remove(key);
+            }
+        });
+    }
+    {
+        Tree tree(rb::sortedUnique, base.begin(), base.end());
+        batchTime = seconds([&]{
+            if(insert) tree.insertBatch(batch.begin(), batch.end());
+            else tree.removeBatch(batch.begin(), batch.end());
+        });
+        if(!tree.isValidRBTree()) cout << "INVALID TREE after " << what << endl;
+    }
+
+    cout << left << setw(28) << what << right << setw(10) << batch.size() << fixed << setprecision(2)
+         << setw(12) << batch.size() / loopTime / 1e6 << setw(12) << batch.size() / batchTime / 1e6
+         << setw(9) << loopTime / batchTime << "x" << endl;
+}
+
+int main(int argc, char* argv[]){
+    size_t n = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    vector<int> base(n);
+    for(size_t i = 0; i < n; i++) base[i] = static_cast<int>(2 * i);
+    mt19937 random(12345);
+
+    cout << "n = " << n << ", rebuild from m >= n / " << Tree::batchRebuildRatio << endl;
+    cout << left << setw(28) << "operation" << right << setw(10) << "m" << setw(12) << "loop Mk/s"
+         << setw(12) << "batch Mk/s" << setw(10) << "speedup" << endl;
+
+    for(size_t m = max<size_t>(n / 1000, 1); m <= n; m *= 10){
+        vector<int> odd(n), even = base;
+        for(size_t i = 0; i < n; i++) odd[i] = static_cast<int>(2 * i + 1);
+
+        //random: any m keys, clustered: m consecutive keys starting anywhere, in random order
+        shuffle(odd.begin(), odd.end(), random);
+        shuffle(even.begin(), even.end(), random);
+        vector<int> randomInsert(odd.begin(), odd.begin() + m);
+        vector<int> randomRemove(even.begin(), even.begin() + m);
+
+        size_t offset = random() % (n - m + 1);
+        vector<int> clusteredInsert(m), clusteredRemove(m);
+        for(size_t i = 0; i < m; i++){
+            clusteredInsert[i] = static_cast<int>(2 * (offset + i) + 1);
+            clusteredRemove[i] = static_cast<int>(2 * (offset + i));
+        }
+        shuffle(clusteredInsert.begin(), clusteredInsert.end(), random);
+        shuffle(clusteredRemove.begin(), clusteredRemove.end(), random);
+
+        compare("insert random", base, randomInsert, true);
+        compare("insert clustered", base, clusteredInsert, true);
+        compare("remove random", base, randomRemove, false);
+        compare("remove clustered", base, clusteredRemove, false);
+    }
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*
+bulk load and set operations vs repeated insert()/remove()
+
+build       n sorted keys: sortedUnique constructor vs insert() in sorted and in shuffled order
+union       a (n keys) with b (m keys): unionWith vs insert() of every key of b
+intersect   a with b: intersectWith vs remove() of every key of a missing in b
+difference  a minus b: differenceWith vs remove() of every key of b
+split/join  split a in the middle and join it back, and join two halves built with their own
+            pools (copied) and sharing one pool (get_allocator(), O(log n))
+
+every result is checked with isValidRBTree() and its size.
+
+build: g++ -O2 -std=c++20 -I. benchmark/BulkBenchmark.c++ -o output/BulkBenchmark
+run:   ./output/BulkBenchmark [n, default 1000000]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RBTree.h"
+using namespace std;
+
+template<class Function>
+double seconds(Function&& function){
+    auto start = chrono::steady_clock::now();
+    function();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+template<class Tree>
+void check(const Tree& tree, size_t expectedSize, const string& what){
+    if(!tree.isValidRBTree() || tree.size() != expectedSize){
+        cout << "FAILED: " << what << " (size " << tree.size() << ", expected " << expectedSize << ")" << endl;
+        exit(1);
+    }
+}
+
+void report(const string& what, double fast, double slow){
+    cout << left << setw(34) << what << right << fixed << setprecision(1)
+         << setw(10) << fast * 1000 << " ms" << setw(10) << slow * 1000 << " ms"
+         << setw(9) << setprecision(1) << slow / fast << "x" << endl;
+}
+
+template<class Tree>
+void buildBenchmark(const string& name, const vector<int>& sorted, const vector<int>& shuffled){
+    //the trees live outside the timed code: checking and freeing them is not part of the build
+    Tree bulkTree, sortedTree, shuffledTree;
+    double bulk = seconds([&]{ bulkTree = Tree(rb::sortedUnique, sorted.begin(), sorted.end()); });
+    double sortedInsert = seconds([&]{ for(int key : sorted) sortedTree.insert(key); });
+    double shuffledInsert = seconds([&]{ for(int key : shuffled) shuffledTree.insert(key); });
+    check(bulkTree, sorted.size(), "bulk load");
+    check(sortedTree, sorted.size(), "sorted insert");
+    check(shuffledTree, sorted.size(), "shuffled insert");
+    report(name + " build vs sorted insert", bulk, sortedInsert);
+    report(name + " build vs shuffled insert", bulk, shuffledInsert);
+}
+
+//a: n random keys, b: m random keys from the same range, so they overlap
+template<class Tree>
+void setBenchmark(const string& name, const vector<int>& aKeys, const vector<int>& bKeys){
+    vector<int> expected;
+    Tree a(rb::sortedUnique, aKeys.begin(), aKeys.end());
+    Tree b(rb::sortedUnique, bKeys.begin(), bKeys.end());
+    string suffix = " m=" + to_string(bKeys.size());
+
+    set_union(aKeys.begin(), aKeys.end(), bKeys.begin(), bKeys.end(), back_inserter(expected));
+    {
+        Tree left(rb::sortedUnique, aKeys.begin(), aKeys.end());
+        Tree slow(rb::sortedUnique, aKeys.begin(), aKeys.end());
+        double fast = seconds([&]{ left.unionWith(b); });
+        double loop = seconds([&]{ for(int key : bKeys) slow.insert(key); });
+        check(left, expected.size(), "union");
+        check(slow, expected.size(), "union loop");
+        report(name + " union" + suffix, fast, loop);
+    }
+
+    expected.clear();
+    set_intersection(aKeys.begin(), aKeys.end(), bKeys.begin(), bKeys.end(), back_inserter(expected));
+    {
+        vector<int> missing;
+        set_difference(aKeys.begin(), aKeys.end(), bKeys.begin(), bKeys.end(), back_inserter(missing));
+        Tree left(rb::sortedUnique, aKeys.begin(), aKeys.end());
+        Tree slow(rb::sortedUnique, aKeys.begin(), aKeys.end());
+        double fast = seconds([&]{ left.intersectWith(b); });
+        double loop = seconds([&]{ for(int key : missing) slow.remove(key); });
+        check(left, expected.size(), "intersection");
+        check(slow, expected.size(), "intersection loop");
+        report(name + " intersect" + suffix, fast, loop);
+    }
+
+    expected.clear();
+    set_difference(aKeys.begin(), aKeys.end(), bKeys.begin(), bKeys.end(), back_inserter(expected));
+    {
+        Tree left(rb::sortedUnique, aKeys.begin(), aKeys.end());
+        Tree slow(rb::sortedUnique, aKeys.begin(), aKeys.end());
+        double fast = seconds([&]{ left.differenceWith(b); });
+        double loop = seconds([&]{ for(int key : bKeys) slow.remove(key); });
+        check(left, expected.size(), "difference");
+        check(slow, expected.size(), "difference loop");
+        report(name + " difference" + suffix, fast, loop);
+    }
+
+    {
+        int middle = aKeys[aKeys.size() / 2];
+        Tree upper;
+        double splitTime = seconds([&]{ upper = a.split(middle); });
+        check(a, aKeys.size() / 2, "split left");
+        check(upper, aKeys.size() - aKeys.size() / 2, "split right");
+        double joinTime = seconds([&]{ a.join(std::move(upper)); });
+        check(a, aKeys.size(), "join");
+        if(bKeys.size() == aKeys.size() / 1000){
+            cout << left << setw(34) << (name + " split + join") << right << fixed << setprecision(3)
+                 << setw(10) << (splitTime + joinTime) * 1000 << " ms" << endl;
+        }
+    }
+
+    //join of two halves built apart: each with its own pool (copied) and sharing the first one's
+    if(bKeys.size() == aKeys.size() / 1000){
+        auto middle = aKeys.begin() + aKeys.size() / 2;
+        Tree low(rb::sortedUnique, aKeys.begin(), middle);
+        Tree high(rb::sortedUnique, middle, aKeys.end());
+        double ownTime = seconds([&]{ low.join(std::move(high)); });
+        check(low, aKeys.size(), "join own pools");
+
+        Tree sharedLow(rb::sortedUnique, aKeys.begin(), middle);
+        Tree sharedHigh(less<int>(), sharedLow.get_allocator());
+        sharedHigh.assignSorted(middle, aKeys.end());
+        double sharedTime = seconds([&]{ sharedLow.join(std::move(sharedHigh)); });
+        check(sharedLow, aKeys.size(), "join shared pool");
+
+        cout << left << setw(34) << (name + " join own / shared pool") << right << fixed << setprecision(3)
+             << setw(10) << ownTime * 1000 << " ms" << setw(10) << sharedTime * 1000 << " ms" << endl;
+    }
+}
+
+//n distinct random keys out of [0, range), sorted
+vector<int> randomKeys(size_t n, int range, mt19937& random){
+    vector<int> keys;
+    uniform_int_distribution<int> distribution(0, range - 1);
+    while(keys.size() < n){
+        size_t missing = n - keys.size();
+        for(size_t i = 0; i < missing; i++) keys.push_back(distribution(random));
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    }
+    return keys;
+}
+
+template<class Tree>
+void runAll(const string& name, size_t n){
+    mt19937 random(12345);
+    vector<int> sorted(n);
+    for(size_t i = 0; i < n; i++) sorted[i] = static_cast<int>(i);
+    vector<int> shuffled = sorted;
+    shuffle(shuffled.begin(), shuffled.end(), random);
+    buildBenchmark<Tree>(name, sorted, shuffled);
+
+    int range = static_cast<int>(4 * n);
+    vector<int> aKeys = randomKeys(n, range, random);
+    for(size_t m : { n / 1000, n / 100, n / 10, n }){
+        if(m == 0) continue;
+        setBenchmark<Tree>(name, aKeys, randomKeys(m, range, random));
+    }
+    cout << endl;
+}
+
+int main(int argc, char* argv[]){
+    size_t n = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+    cout << "n = " << n << left << setw(27) << "" << right << setw(13) << "bulk/set op" << setw(13) << "per key" << setw(10) << "speedup" << endl;
+
+    runAll<rb::RBSet<int>>("PackedPointer", n);
+    runAll<rb::RBSet<int, less<int>, rb::NodePool<int>, rb::IndexLayout>>("Index", n);
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+read scaling of rb::ConcurrentRBSet against the current practice, an rb::RBSet behind one std::mutex
+
+every thread runs a random mix of contains() and insert()/remove() (half each) on keys in [0, 2n)
+for a fixed time, the tree starts with n of them. mixes 90/10 and 50/50 reads/writes, 1 to t threads.
+reported: total and read throughput, and the read throughput relative to one thread.
+the scaling only shows on a machine with more than one core
+
+build: g++ -O2 -std=c++20 -pthread -I. benchmark/ConcurrentBenchmark.c++ -o output/ConcurrentBenchmark
+run:   ./output/ConcurrentBenchmark [n, default 1000000] [max threads, default hardware threads] [ms per point, default 500]
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentRBTree.h"
+#include "RBTree.h"
+using namespace std;
+
+//the same interface for both contenders
+struct LockedSet{
+    rb::RBSet<int> tree;
+    mutable mutex lock;
+
+    bool contains(int key) const{
+        lock_guard<mutex> guard(lock);
+        return tree.contains(key);
+    }
+    bool insert(int key){
+        lock_guard<mutex> guard(lock);
+        return tree.insert(key);
+    }
+    bool remove(int key){
+        lock_guard<mutex> guard(lock);
+        return tree.remove(key);
+    }
+};
+
+struct Result{
+    double totalOps;        //per second
+    double readOps;
+};
+
+template<class Set>
+Result run(Set& set, size_t n, int threads, int readPercent, int milliseconds){
+    atomic<bool> start{false}, stop{false};
+    vector<uint64_t> reads(threads), writes(threads);
+    vector<thread> workers;
+
+    for(int t = 0; t < threads; t++){
+        workers.emplace_back([&, t]{
+            mt19937_64 random(1000 + t);
+            uint64_t readCount = 0, writeCount = 0, found = 0;
+            while(!start.load(memory_order_acquire)) this_thread::yield();
+
+            while(!stop.load(memory_order_relaxed)){
+                //check the clock flag only every 64 operations
+                for(int i = 0; i < 64; i++){
+                    uint64_t bits = random();
+                    int key = static_cast<int>((bits >> 8) % (2 * n));
+                    if(static_cast<int>(bits % 100) < readPercent){
+                        found += set.contains(key);
+                        readCount++;
+                    }
+                    else{
+                        if(bits & 128) set.insert(key);
+                        else set.remove(key);
+                        writeCount++;
+                    }
+                }
+            }
+            reads[t] = readCount + (found == 42 ? 1 : 0);
+            writes[t] = writeCount;
+        });
+    }
+
+    auto begin = chrono::steady_clock::now();
+    start.store(true, memory_order_release);
+    this_thread::sleep_for(chrono::milliseconds(milliseconds));
+    stop.store(true);
+    for(thread& worker : workers) worker.join();
+    double time = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    uint64_t readTotal = 0, writeTotal = 0;
+    for(int t = 0; t < threads; t++){
+        readTotal += reads[t];
+        writeTotal += writes[t];
+    }
+    return { (readTotal + writeTotal) / time, readTotal / time };
+}
+
+template<class Set>
+void benchmark(const string& name, size_t n, int maxThreads, int milliseconds){
+    vector<int> keys(2 * n);
+    for(size_t i = 0; i < keys.size(); i++) keys[i] = static_cast<int>(i);
+    shuffle(keys.begin(), keys.end(), mt19937(12345));
+
+    for(int readPercent : { 90, 50 }){
+        double oneThread = 0;
+        for(int threads = 1; threads <= maxThreads; threads *= 2){
+            Set set;
+            for(size_t i = 0; i < n; i++) set.insert(keys[i]);
+
+            Result result = run(set, n, threads, readPercent, milliseconds);
+            if(threads == 1) oneThread = result.readOps;
+
+            cout << left << setw(24) << name << right << setw(4) << readPercent << "/" << left << setw(4) << 100 - readPercent
+                 << right << setw(8) << threads << fixed << setprecision(2)
+                 << setw(14) << result.totalOps / 1e6 << setw(14) << result.readOps / 1e6
+                 << setw(12) << result.readOps / oneThread << "x" << endl;
+
+            if(threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2;
+        }
+    }
+}
+
+int main(int argc, char* argv[]){
+    size_t n = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+    int maxThreads = (argc > 2) ? atoi(argv[2]) : static_cast<int>(max(1u, thread::hardware_concurrency()));
+    int milliseconds = (argc > 3) ? atoi(argv[3]) : 500;
+
+    cout << "n = " << n << ", " << thread::hardware_concurrency() << " hardware threads" << endl;
+    cout << left << setw(24) << "tree" << right << setw(9) << "mix" << setw(8) << "threads"
+         << setw(14) << "Mops/s" << setw(14) << "Mreads/s" << setw(13) << "read scale" << endl;
+
+    benchmark<LockedSet>("RBSet + mutex", n, maxThreads, milliseconds);
+    benchmark<rb::ConcurrentRBSet<int>>("ConcurrentRBSet", n, maxThreads, milliseconds);
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+what the balancing code does per operation, from the hot-path counters of Counters.h
+
+for every key pattern of KeyPatterns.h and every size, each tree inserts the workload's keys
+into an empty tree and removes them again; the counters of each phase are divided by the
+inserts / removes that changed the tree
+    rot      rotations per insert / remove
+    loops    iterations of the fixInsert / fixRemove loop per insert / remove
+    c1 ..    how often each case of fixInsert (1-3) and fixRemove (1-4) ran, per insert / remove
+    height   nodes on the longest path after the inserts, next to the 2 log2(n + 1) bound
+the counters only exist when everything is compiled with RB_COUNTERS=1, the CMake target
+CounterReport does that for itself and its own copy of the original trees.
+
+build: g++ -O2 -std=c++20 -DRB_COUNTERS=1 -I. benchmark/CounterReport.c++ RBTreeImplement.c++ RBTreeAI.c++ -o output/CounterReport
+       (or the CMake target CounterReport)
+run:   ./output/CounterReport [max keys, default 1000000] [min keys, default 1000]
+*/
+
+#if !defined(RB_COUNTERS) || !RB_COUNTERS
+#error "CounterReport needs the hot-path counters, compile with -DRB_COUNTERS=1"
+#endif
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "KeyPatterns.h"
+#include "RBTree.h"
+#include "RBTreeAI.h"
+#include "RBTreeImplement.h"
+using namespace std;
+
+using bench::Pattern;
+using bench::Workload;
+
+double perOperation(uint64_t count, uint64_t operations){
+    return operations ? double(count) / double(operations) : 0.0;
+}
+
+template<class Tree>
+void runTree(const string& name, size_t n, Pattern pattern, const Workload& workload){
+    Tree tree;
+    rb::HotPathCounters& counters = rb::hotPathCounters();
+
+    counters = {};
+    for(int key : workload.insert) tree.insert(key);
+    rb::HotPathCounters inserted = counters;
+    size_t height = size_t(tree.height());
+
+    counters = {};
+    for(int key : workload.remove) tree.remove(key);
+    rb::HotPathCounters removed = counters;
+
+    uint64_t inserts = inserted.inserts, removes = removed.removes;
+    cout << right << setw(10) << n << "  " << left << setw(12) << bench::patternName(pattern) << setw(19) << name
+         << right << fixed << setprecision(3)
+         << setw(7) << perOperation(inserted.insertRotations, inserts) << setw(7) << perOperation(inserted.insertFixupLoops, inserts)
+         << setw(7) << perOperation(inserted.insertCase1, inserts) << setw(7) << perOperation(inserted.insertCase2, inserts)
+         << setw(7) << perOperation(inserted.insertCase3, inserts) << " |"
+         << setw(7) << perOperation(removed.removeRotations, removes) << setw(7) << perOperation(removed.removeFixupLoops, removes)
+         << setw(7) << perOperation(removed.removeCase1, removes) << setw(7) << perOperation(removed.removeCase2, removes)
+         << setw(7) << perOperation(removed.removeCase3, removes) << setw(7) << perOperation(removed.removeCase4, removes) << " |"
+         << setw(5) << height << " / " << setprecision(1) << 2 * log2(double(inserts) + 1) << endl;
+}
+
+int main(int argc, char* argv[]){
+    size_t maxKeys = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t minKeys = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 1000;
+
+    cout << right << setw(10) << "keys" << "  " << left << setw(12) << "pattern" << setw(19) << "tree" << right
+         << setw(7) << "rot" << setw(7) << "loops" << setw(7) << "c1" << setw(7) << "c2" << setw(7) << "c3" << " |"
+         << setw(7) << "rot" << setw(7) << "loops" << setw(7) << "c1" << setw(7) << "c2" << setw(7) << "c3" << setw(7) << "c4" << " |"
+         << setw(13) << "height/bound" << endl;
+    cout << setw(44) << "" << setw(36) << "per insert" << setw(44) << "per remove" << endl;
+
+    for(size_t n = minKeys; n <= maxKeys; n *= 10){
+        for(Pattern pattern : bench::allPatterns){
+            Workload workload = bench::makeWorkload(pattern, n);
+            runTree<rb::RBSet<int>>("rb::RBSet", n, pattern, workload);
+            runTree<implement::RBTree>("implement::RBTree", n, pattern, workload);
+            runTree<ai::RBTree>("ai::RBTree", n, pattern, workload);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+iteration and lookups of rb::RBSet against std::set, output in the style of google-benchmark
+(one line per case: name/size, time per iteration, items per second)
+
+BM_Iterate     walk all n keys with begin()..end()
+BM_ForEach     rb::RBSet::forEach, the explicit-stack scan that prefetches right children
+BM_Find        n random successful finds
+BM_RangeScan   lower_bound + walk 100 keys, n / 100 times
+
+"Random" trees are built by inserting shuffled keys one by one, so nodes are scattered in
+allocation order, "Bulk" trees come from the sorted O(n) build and sit in key order in memory.
+the same case is repeated until it has run for at least 0.5 s, the mean is reported.
+no google-benchmark dependency, the harness below only copies the output format
+
+build: g++ -O2 -std=c++20 -I. benchmark/IterationBenchmark.c++ -o output/IterationBenchmark
+run:   ./output/IterationBenchmark [n, default 1000000]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "RBTree.h"
+using namespace std;
+
+//keeps the compiler from dropping the loops
+static uint64_t sink = 0;
+
+template<class Function>
+void runBenchmark(const string& name, size_t items, Function&& function){
+    using Clock = chrono::steady_clock;
+    size_t iterations = 0;
+    auto start = Clock::now();
+    double elapsed = 0;
+    do{
+        function();
+        iterations++;
+        elapsed = chrono::duration<double>(Clock::now() - start).count();
+    }while(elapsed < 0.5);
+
+    double perIteration = elapsed / iterations;
+    cout << left << setw(44) << name << right << fixed << setprecision(2)
+         << setw(12) << perIteration * 1e3 << " ms" << setw(10) << iterations
+         << setprecision(1) << setw(14) << items / perIteration / 1e6 << "M items/s" << endl;
+}
+
+template<class Set>
+void benchmarkSet(const string& name, const Set& set, const vector<int>& probes, size_t n){
+    string size = "/" + to_string(n);
+
+    runBenchmark("BM_Iterate<" + name + ">" + size, n, [&]{
+        uint64_t sum = 0;
+        for(auto it = set.begin(); it != set.end(); ++it) sum += *it;
+        sink += sum;
+    });
+
+    if constexpr (requires { set.forEach([](int){}); }){
+        runBenchmark("BM_ForEach<" + name + ">" + size, n, [&]{
+            uint64_t sum = 0;
+            set.forEach([&](int key){ sum += key; });
+            sink += sum;
+        });
+    }
+
+    runBenchmark("BM_Find<" + name + ">" + size, probes.size(), [&]{
+        uint64_t found = 0;
+        for(int key : probes) found += (set.find(key) != set.end());
+        sink += found;
+    });
+
+    runBenchmark("BM_RangeScan<" + name + ">" + size, probes.size() / 100 * 100, [&]{
+        uint64_t sum = 0;
+        for(size_t i = 0; i < probes.size() / 100; i++){
+            auto it = set.lower_bound(probes[i]);
+            for(int j = 0; j < 100 && it != set.end(); j++, ++it) sum += *it;
+        }
+        sink += sum;
+    });
+}
+
+int main(int argc, char* argv[]){
+    size_t n = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    mt19937 random(12345);
+    vector<int> sorted(n);
+    for(size_t i = 0; i < n; i++) sorted[i] = static_cast<int>(2 * i);
+    vector<int> shuffled = sorted;
+    shuffle(shuffled.begin(), shuffled.end(), random);
+    vector<int> probes = sorted;
+    shuffle(probes.begin(), probes.end(), random);
+
+    cout << left << setw(44) << "Benchmark" << right << setw(15) << "Time" << setw(10) << "Iters"
+         << setw(23) << "Throughput" << endl << string(92, '-') << endl;
+
+    {
+        set<int> stdSet;
+        for(int key : shuffled) stdSet.insert(key);
+        benchmarkSet("std::set/Random", stdSet, probes, n);
+    }
+    {
+        rb::RBSet<int> tree;
+        for(int key : shuffled) tree.insert(key);
+        benchmarkSet("RBSet/Random", tree, probes, n);
+    }
+    {
+        set<int> stdSet(sorted.begin(), sorted.end());
+        benchmarkSet("std::set/Bulk", stdSet, probes, n);
+    }
+    {
+        rb::RBSet<int> tree(rb::sortedUnique, sorted.begin(), sorted.end());
+        benchmarkSet("RBSet/Bulk", tree, probes, n);
+    }
+    {
+        rb::RBSet<int, less<int>, rb::NodePool<int>, rb::IndexLayout> tree(rb::sortedUnique, sorted.begin(), sorted.end());
+        benchmarkSet("RBSet<IndexLayout>/Bulk", tree, probes, n);
+    }
+
+    return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+/*
+key patterns shared by RBTreeBenchmark.c++ and CounterReport.c++
+
+a workload is three key sequences of length n: the inserts, then the lookups, then the removes
+    sequential    0, 1, .. n - 1 for all three (removes always take the minimum)
+    random        a shuffled permutation of 0 .. n - 1, shuffled again for lookups and removes
+    zipfian       keys drawn from a Zipf distribution (theta 0.99) over n ranks, a few hot keys
+                  repeat often, so many inserts are duplicates and many removes miss
+    adversarial   zigzag 0, n - 1, 1, n - 2, .. every insert lands next to the previous
+                  opposite-side key, the inner grandchild positions which cost a double rotation
+the same seed gives the same keys, so every tree runs exactly the same workload
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+enum class Pattern { Sequential, Random, Zipfian, Adversarial };
+
+inline constexpr Pattern allPatterns[] = { Pattern::Sequential, Pattern::Random, Pattern::Zipfian, Pattern::Adversarial };
+
+inline std::string patternName(Pattern pattern){
+    switch(pattern){
+        case Pattern::Sequential: return "sequential";
+        case Pattern::Random: return "random";
+        case Pattern::Zipfian: return "zipfian";
+        case Pattern::Adversarial: return "adversarial";
+    }
+    return "?";
+}
+
+/*
+Zipf ranks 0 .. n - 1, rank r drawn with probability proportional to 1 / (r + 1)^theta
+(the rejection-free generator of Gray et al., "Quickly Generating Billion-Record Synthetic
+Databases", the one YCSB uses), the O(n) zeta sum is paid once in the constructor
+*/
+class ZipfianGenerator{
+    private:
+        std::uint64_t n_;
+        double theta_, alpha_, zetan_, eta_;
+
+    public:
+        explicit ZipfianGenerator(std::uint64_t n, double theta = 0.99) : n_(n), theta_(theta){
+            double zeta2 = 1 + std::pow(0.5, theta);
+            zetan_ = 0;
+            for(std::uint64_t i = 1; i <= n; i++) zetan_ += 1 / std::pow(double(i), theta);
+            alpha_ = 1 / (1 - theta);
+            eta_ = (1 - std::pow(2.0 / double(n), 1 - theta)) / (1 - zeta2 / zetan_);
+        }
+
+        template<class Random>
+        std::uint64_t operator()(Random& random){
+            double u = std::uniform_real_distribution<double>(0, 1)(random);
+            double uz = u * zetan_;
+            if(uz < 1) return 0;
+            if(uz < 1 + std::pow(0.5, theta_)) return 1;
+            return std::min<std::uint64_t>(n_ - 1, std::uint64_t(double(n_) * std::pow(eta_ * u - eta_ + 1, alpha_)));
+        }
+};
+
+struct Workload{
+    std::vector<int> insert;
+    std::vector<int> find;
+    std::vector<int> remove;
+};
+
+inline Workload makeWorkload(Pattern pattern, std::size_t n, std::uint64_t seed = 12345){
+    std::mt19937_64 random(seed);
+    Workload workload;
+
+    switch(pattern){
+        case Pattern::Sequential:
+            workload.insert.resize(n);
+            std::iota(workload.insert.begin(), workload.insert.end(), 0);
+            workload.find = workload.insert;
+            workload.remove = workload.insert;
+            break;
+
+        case Pattern::Random:
+            workload.insert.resize(n);
+            std::iota(workload.insert.begin(), workload.insert.end(), 0);
+            std::shuffle(workload.insert.begin(), workload.insert.end(), random);
+            workload.find = workload.insert;
+            std::shuffle(workload.find.begin(), workload.find.end(), random);
+            workload.remove = workload.insert;
+            std::shuffle(workload.remove.begin(), workload.remove.end(), random);
+            break;
+
+        case Pattern::Zipfian:{
+            //hot ranks are spread over the key space: rank * odd constant, kept to the low 31 bits, is a bijection
+            //on the ranks mod 2^31, so distinct ranks stay distinct non-negative keys
+            ZipfianGenerator zipf(n);
+            auto draw = [&](std::vector<int>& keys){
+                keys.resize(n);
+                for(int& key : keys) key = int((std::uint32_t(zipf(random)) * 2654435761u) & 0x7fffffffu);
+            };
+            draw(workload.insert);
+            draw(workload.find);
+            draw(workload.remove);
+            break;
+        }
+
+        case Pattern::Adversarial:
+            workload.insert.resize(n);
+            for(std::size_t i = 0; i < n; i++){
+                workload.insert[i] = int(i % 2 == 0 ? i / 2 : n - 1 - i / 2);
+            }
+            workload.find = workload.insert;
+            workload.remove = workload.insert;
+            break;
+    }
+    return workload;
+}
+
+}   //namespace bench
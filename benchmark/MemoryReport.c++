@@ -0,0 +1,117 @@
+/*
+memory per key of the node layouts
+
+for every layout, insert n distinct random keys (32-bit and 64-bit) and report
+    node     sizeof(Node)
+    heap     bytes held by the allocator after the inserts (malloc_usable_size of every live block)
+    per key  heap / n
+plus the time of inserting and removing all keys, to see what the smaller nodes do to the cache.
+
+the baseline is the struct of RBTreeImplement.c++: Color + int + three pointers.
+heap counts usable bytes only, malloc's own header in front of every block comes on top of it,
+so per-node new/delete costs even more than shown.
+
+build: g++ -O2 -std=c++20 -I. benchmark/MemoryReport.c++ -o output/MemoryReport
+run:   ./output/MemoryReport [number of keys, default 1000000]
+*/
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RBTree.h"
+using namespace std;
+
+//live heap bytes, counted through the global allocator
+static size_t liveBytes = 0;
+
+void* operator new(size_t size){
+    if(void* p = malloc(size ? size : 1)){
+        liveBytes += malloc_usable_size(p);
+        return p;
+    }
+    throw bad_alloc();
+}
+void* operator new(size_t size, align_val_t align){
+    size_t alignment = static_cast<size_t>(align);
+    if(void* p = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)){
+        liveBytes += malloc_usable_size(p);
+        return p;
+    }
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept{
+    if(p) liveBytes -= malloc_usable_size(p);
+    free(p);
+}
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete(void* p, align_val_t) noexcept { operator delete(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { operator delete(p); }
+
+//the node of RBTreeImplement.c++
+struct LegacyNode{
+    rb::Color color;
+    int data;
+    LegacyNode* left;
+    LegacyNode* right;
+    LegacyNode* parent;
+};
+
+template<class Tree, class Key>
+void report(const string& name, const vector<Key>& keys){
+    size_t n = keys.size();
+    size_t before = liveBytes;
+
+    auto start = chrono::steady_clock::now();
+    Tree tree;
+    for(Key key : keys) tree.insert(key);
+    auto inserted = chrono::steady_clock::now();
+    size_t heap = liveBytes - before;
+
+    for(Key key : keys) tree.remove(key);
+    auto removed = chrono::steady_clock::now();
+
+    cout << left << setw(26) << name
+         << right << setw(6) << sizeof(typename Tree::Node) << " B"
+         << setw(12) << fixed << setprecision(1) << heap / 1048576.0 << " MiB"
+         << setw(9) << setprecision(1) << double(heap) / n << " B/key"
+         << setw(10) << setprecision(1) << chrono::duration<double>(inserted - start).count() * 1000 << " ms insert"
+         << setw(10) << setprecision(1) << chrono::duration<double>(removed - inserted).count() * 1000 << " ms remove"
+         << endl;
+}
+
+template<class Key>
+void reportAll(const vector<Key>& keys){
+    cout << left << setw(26) << ("layout, " + to_string(sizeof(Key) * 8) + "-bit keys")
+         << right << setw(8) << "node" << setw(16) << "heap" << setw(15) << "per key" << endl;
+
+    report<rb::RBSet<Key, less<Key>, allocator<Key>, rb::PointerLayout>>("Pointer, new/delete", keys);
+    report<rb::RBSet<Key, less<Key>, rb::NodePool<Key>, rb::PointerLayout>>("Pointer, NodePool", keys);
+    report<rb::RBSet<Key, less<Key>, allocator<Key>, rb::PackedPointerLayout>>("PackedPointer, new/delete", keys);
+    report<rb::RBSet<Key, less<Key>, rb::NodePool<Key>, rb::PackedPointerLayout>>("PackedPointer, NodePool", keys);
+    report<rb::RBSet<Key, less<Key>, allocator<Key>, rb::IndexLayout>>("Index", keys);
+    cout << endl;
+}
+
+int main(int argc, char* argv[]){
+    size_t n = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    mt19937 random(12345);
+    vector<int> keys(n);
+    for(size_t i = 0; i < n; i++) keys[i] = static_cast<int>(i);
+    shuffle(keys.begin(), keys.end(), random);
+    vector<long long> wideKeys(keys.begin(), keys.end());
+
+    cout << "keys: " << n << ", RBTreeImplement.c++ node: " << sizeof(LegacyNode) << " B" << endl << endl;
+    reportAll(keys);
+    reportAll(wideKeys);
+    return 0;
+}
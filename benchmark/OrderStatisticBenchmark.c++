@@ -0,0 +1,89 @@
+/*
+cost and payoff of the SubtreeSize augmentation
+
+update   insert n random keys and remove them again, rb::RBSet vs rb::OrderStatisticSet
+         (the difference is what keeping the subtree sizes costs)
+query    q random select(k) / rank(key) / countRange(lo, hi), against the O(n) walk
+         std::distance over a std::set which is the only way without subtree sizes
+
+build: g++ -O2 -std=c++20 -I. benchmark/OrderStatisticBenchmark.c++ -o output/OrderStatisticBenchmark
+run:   ./output/OrderStatisticBenchmark [n, default 1000000] [q, default 100]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "RBTree.h"
+using namespace std;
+
+template<class Function>
+double seconds(Function&& function){
+    auto start = chrono::steady_clock::now();
+    function();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void report(const string& what, size_t ops, double time){
+    cout << left << setw(40) << what << right << fixed << setprecision(1)
+         << setw(10) << time * 1000 << " ms" << setw(12) << setprecision(0) << time / ops * 1e9 << " ns/op" << endl;
+}
+
+template<class Tree>
+void updateBenchmark(const string& name, const vector<int>& keys){
+    Tree tree;
+    report(name + " insert", keys.size(), seconds([&]{ for(int key : keys) tree.insert(key); }));
+    report(name + " remove", keys.size(), seconds([&]{ for(int key : keys) tree.remove(key); }));
+}
+
+int main(int argc, char* argv[]){
+    size_t n = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t q = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 100;
+
+    mt19937 random(12345);
+    vector<int> keys(n);
+    for(size_t i = 0; i < n; i++) keys[i] = static_cast<int>(2 * i);
+    shuffle(keys.begin(), keys.end(), random);
+
+    cout << "n = " << n << ", node size " << sizeof(rb::RBSet<int>::Node) << " B plain, "
+         << sizeof(rb::OrderStatisticSet<int>::Node) << " B with subtree sizes" << endl;
+    updateBenchmark<rb::RBSet<int>>("RBSet", keys);
+    updateBenchmark<rb::OrderStatisticSet<int>>("OrderStatisticSet", keys);
+
+    rb::OrderStatisticSet<int> tree;
+    set<int> reference(keys.begin(), keys.end());
+    for(int key : keys) tree.insert(key);
+
+    uniform_int_distribution<size_t> position(0, n - 1);
+    uniform_int_distribution<int> value(0, static_cast<int>(2 * n));
+    vector<size_t> ks(q);
+    vector<int> los(q), his(q);
+    for(size_t i = 0; i < q; i++){
+        ks[i] = position(random);
+        los[i] = value(random);
+        his[i] = los[i] + value(random) / 8;
+    }
+
+    //the checksum keeps the compiler from dropping the queries and compares both answers
+    long long fast = 0, slow = 0;
+    report("select(k)", q, seconds([&]{ for(size_t k : ks) fast += tree.select(k); }));
+    report("select(k), std::set walk", q, seconds([&]{ for(size_t k : ks) slow += *next(reference.begin(), k); }));
+    report("rank(key)", q, seconds([&]{ for(int lo : los) fast += tree.rank(lo); }));
+    report("rank(key), std::set walk", q, seconds([&]{
+        for(int lo : los) slow += distance(reference.begin(), reference.lower_bound(lo));
+    }));
+    report("countRange(lo, hi)", q, seconds([&]{ for(size_t i = 0; i < q; i++) fast += tree.countRange(los[i], his[i]); }));
+    report("countRange(lo, hi), std::set walk", q, seconds([&]{
+        for(size_t i = 0; i < q; i++) slow += distance(reference.lower_bound(los[i]), reference.upper_bound(his[i]));
+    }));
+
+    if(fast != slow) cout << "MISMATCH between the tree and std::set" << endl;
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*
+throughput and latency of the trees on the key patterns of KeyPatterns.h
+
+trees     rb::RBSet (packed pointers), rb::RBSet with IndexLayout, implement::RBTree,
+          ai::RBTree and std::set<int> as the baseline
+phases    n inserts into an empty tree, n lookups, n removes, the keys of one workload
+sizes     1K, 10K, .. up to the maximum (1M by default, at 100M every tree needs a few GB)
+
+Mops/s is the whole phase divided by its time. p50 / p99 come from timing every
+sampleEvery-th operation on its own, minus the cost of reading the clock, so the sampling
+leaves the phase time nearly untouched. a timed operation runs alone (the clock reads keep
+it from overlapping its neighbours), so p50 can be above 1 / throughput; inserts are timed
+on a tree that is filling up, removes on one that is draining.
+
+build: g++ -O2 -std=c++20 -I. benchmark/RBTreeBenchmark.c++ RBTreeImplement.c++ RBTreeAI.c++ -o output/RBTreeBenchmark
+       (or the CMake target RBTreeBenchmark)
+run:   ./output/RBTreeBenchmark [max keys, default 1000000] [min keys, default 1000]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "KeyPatterns.h"
+#include "RBTree.h"
+#include "RBTreeAI.h"
+#include "RBTreeImplement.h"
+using namespace std;
+
+using bench::Pattern;
+using bench::Workload;
+using Clock = chrono::steady_clock;
+
+constexpr size_t sampleEvery = 32;
+
+//std::set spells remove erase
+void removeKey(set<int>& tree, int key) { tree.erase(key); }
+template<class Tree>
+void removeKey(Tree& tree, int key) { tree.remove(key); }
+
+//median of timing an empty region, taken off every sample
+double clockOverhead(){
+    vector<double> samples(10001);
+    for(double& sample : samples){
+        auto start = Clock::now();
+        sample = chrono::duration<double, nano>(Clock::now() - start).count();
+    }
+    nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+struct PhaseResult{
+    double mopsPerSecond;
+    double p50;
+    double p99;
+};
+
+double percentile(vector<double>& samples, double fraction){
+    if(samples.empty()) return 0;
+    size_t index = min(samples.size() - 1, size_t(fraction * double(samples.size())));
+    nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+//op(key) for every key, the sampled ones timed on their own
+template<class Operation>
+PhaseResult runPhase(const vector<int>& keys, double overhead, Operation&& op){
+    vector<double> samples;
+    samples.reserve(keys.size() / sampleEvery + 1);
+
+    auto start = Clock::now();
+    for(size_t i = 0; i < keys.size(); i++){
+        if(i % sampleEvery == 0){
+            auto opStart = Clock::now();
+            op(keys[i]);
+            double nanoseconds = chrono::duration<double, nano>(Clock::now() - opStart).count();
+            samples.push_back(max(0.0, nanoseconds - overhead));
+        }
+        else op(keys[i]);
+    }
+    double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+    return { double(keys.size()) / elapsed / 1e6, percentile(samples, 0.50), percentile(samples, 0.99) };
+}
+
+void report(size_t n, Pattern pattern, const string& tree, const string& phase, const PhaseResult& result){
+    cout << right << setw(10) << n << "  " << left << setw(12) << bench::patternName(pattern) << setw(22) << tree
+         << setw(8) << phase << right << fixed << setprecision(2) << setw(10) << result.mopsPerSecond
+         << setprecision(0) << setw(10) << result.p50 << setw(10) << result.p99 << endl;
+}
+
+//one workload on a fresh tree, the lookup results are summed so the loop cannot be dropped
+template<class Tree>
+void runTree(const string& name, size_t n, Pattern pattern, const Workload& workload, double overhead){
+    Tree tree;
+    size_t found = 0;
+
+    PhaseResult insert = runPhase(workload.insert, overhead, [&](int key){ tree.insert(key); });
+    PhaseResult find = runPhase(workload.find, overhead, [&](int key){ found += tree.contains(key); });
+    PhaseResult remove = runPhase(workload.remove, overhead, [&](int key){ removeKey(tree, key); });
+
+    report(n, pattern, name, "insert", insert);
+    report(n, pattern, name, "find", find);
+    report(n, pattern, name, "remove", remove);
+    if(found == 0 && n > 0) cout << "no key found" << endl;
+}
+
+int main(int argc, char* argv[]){
+    size_t maxKeys = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t minKeys = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 1000;
+    double overhead = clockOverhead();
+
+    cout << "1 in " << sampleEvery << " operations timed, clock overhead " << fixed << setprecision(1)
+         << overhead << " ns subtracted" << endl;
+    cout << right << setw(10) << "keys" << "  " << left << setw(12) << "pattern" << setw(22) << "tree"
+         << setw(8) << "phase" << right << setw(10) << "Mops/s" << setw(10) << "p50 ns" << setw(10) << "p99 ns" << endl;
+
+    for(size_t n = minKeys; n <= maxKeys; n *= 10){
+        for(Pattern pattern : bench::allPatterns){
+            Workload workload = bench::makeWorkload(pattern, n);
+
+            runTree<rb::RBSet<int>>("rb::RBSet", n, pattern, workload, overhead);
+            runTree<rb::RBSet<int, less<int>, rb::NodePool<int>, rb::IndexLayout>>("rb::RBSet IndexLayout", n, pattern, workload, overhead);
+            runTree<implement::RBTree>("implement::RBTree", n, pattern, workload, overhead);
+            runTree<ai::RBTree>("ai::RBTree", n, pattern, workload, overhead);
+            runTree<set<int>>("std::set", n, pattern, workload, overhead);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+cost of snapshots in rb::PersistentRBSet
+
+the tree starts with n random keys, then runs u random updates (insert a new key / remove an
+existing one, half each) while taking a snapshot every k updates and keeping all of them alive.
+reported per k: update latency (mean, p50, p99), the nodes copied because of the snapshots and
+the memory they hold per snapshot. k = 0 means no snapshots at all.
+last: snapshot() against the only option of rb::RBSet and std::set, copying the whole tree.
+
+build: g++ -O2 -std=c++20 -I. benchmark/SnapshotBenchmark.c++ -o output/SnapshotBenchmark
+run:   ./output/SnapshotBenchmark [n, default 1000000] [u, default 100000]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "PersistentRBTree.h"
+#include "RBTree.h"
+using namespace std;
+
+//counts the nodes alive in all versions
+static size_t liveNodes = 0;
+
+template<class T>
+struct CountingAllocator{
+    using value_type = T;
+    CountingAllocator() = default;
+    template<class U> CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n){
+        liveNodes += n;
+        return allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n){
+        liveNodes -= n;
+        allocator<T>().deallocate(p, n);
+    }
+    template<class U> bool operator==(const CountingAllocator<U>&) const { return true; }
+};
+
+using Tree = rb::PersistentRBSet<int, less<int>, CountingAllocator<int>>;
+
+template<class Function>
+double seconds(Function&& function){
+    auto start = chrono::steady_clock::now();
+    function();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void run(size_t n, size_t u, size_t k){
+    mt19937 random(12345);
+    Tree tree;
+    vector<int> keys;
+    for(size_t i = 0; i < n; i++){
+        int key = static_cast<int>(random() >> 1);
+        if(tree.insert(key)) keys.push_back(key);
+    }
+    size_t baseNodes = liveNodes;
+
+    vector<Tree::Snapshot> snapshots;
+    vector<double> latency(u);
+    for(size_t i = 0; i < u; i++){
+        if(k && i % k == 0) snapshots.push_back(tree.snapshot());
+
+        bool insert = random() & 1;
+        size_t index = random() % keys.size();
+        int key = static_cast<int>(random() >> 1);
+
+        auto start = chrono::steady_clock::now();
+        if(insert) tree.insert(key);
+        else tree.remove(keys[index]);
+        latency[i] = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+        if(insert) keys.push_back(key);
+        else{
+            keys[index] = keys.back();
+            keys.pop_back();
+        }
+    }
+
+    //nodes beyond the live tree's own are the ones only snapshots still hold
+    size_t extraNodes = liveNodes - tree.size();
+    double mean = 0;
+    for(double time : latency) mean += time;
+    mean /= u;
+    sort(latency.begin(), latency.end());
+
+    cout << setw(8) << (k ? to_string(k) : "none") << setw(10) << snapshots.size() << fixed << setprecision(0)
+         << setw(10) << mean << setw(10) << latency[u / 2] << setw(10) << latency[u * 99 / 100]
+         << setw(12) << extraNodes << setprecision(1)
+         << setw(14) << (snapshots.empty() ? 0.0 : double(extraNodes) * sizeof(Tree::Node) / snapshots.size() / 1024) << " KiB"
+         << setprecision(2) << setw(10) << double(liveNodes) / baseNodes << "x" << endl;
+}
+
+int main(int argc, char* argv[]){
+    size_t n = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t u = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 100000;
+
+    cout << "n = " << n << ", u = " << u << " updates, node size " << sizeof(Tree::Node) << " B" << endl;
+    cout << setw(8) << "every k" << setw(10) << "snaps" << setw(10) << "mean ns" << setw(10) << "p50 ns"
+         << setw(10) << "p99 ns" << setw(12) << "copied" << setw(18) << "per snapshot" << setw(11) << "memory" << endl;
+    for(size_t k : { 0, 10000, 1000, 100, 10, 1 }) run(n, u, k);
+
+    //what a consistent view costs without persistence
+    vector<int> sorted(n);
+    for(size_t i = 0; i < n; i++) sorted[i] = static_cast<int>(2 * i);
+    Tree persistent;
+    for(int key : sorted) persistent.insert(key);
+    rb::RBSet<int> plain(rb::sortedUnique, sorted.begin(), sorted.end());
+    set<int> stdSet(sorted.begin(), sorted.end());
+
+    Tree::Snapshot snapshot = persistent.snapshot();
+    double snapshotTime = seconds([&]{ for(int i = 0; i < 1000; i++) snapshot = persistent.snapshot(); }) / 1000;
+    double plainTime = seconds([&]{ rb::RBSet<int> copy(rb::sortedUnique, plain.begin(), plain.end()); });
+    double stdTime = seconds([&]{ set<int> copy(stdSet); });
+    cout << fixed << setprecision(3) << endl
+         << left << setw(32) << "PersistentRBSet::snapshot()" << right << setw(14) << snapshotTime * 1e6 << " us" << endl
+         << left << setw(32) << "RBSet bulk copy" << right << setw(14) << plainTime * 1e6 << " us" << endl
+         << left << setw(32) << "std::set copy" << right << setw(14) << stdTime * 1e6 << " us" << endl;
+    return 0;
+}
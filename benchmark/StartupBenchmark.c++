@@ -0,0 +1,107 @@
+/*
+time from a process start to a tree that answers queries, for n random keys
+
+insert loop       n insert() calls from the flat key list (the current startup)
+sort + bulk load  sort the list, then the O(n) sortedUnique constructor
+load()            RBTree::load() of a saved file: read, checksum, checks, O(n) relink
+mmap + checksum   MappedRBTree on the same file, verifying the checksum
+mmap              MappedRBTree without the checksum, nothing is read before the first query
+each line also times the first 1000 lookups, which is where the mapped file pays for its pages.
+the file is written to the temporary directory and removed again. the page cache is warm, a
+cold start from disk adds the read time of the file to every line except "mmap"
+
+build: g++ -O2 -std=c++20 -I. benchmark/StartupBenchmark.c++ -o output/StartupBenchmark
+run:   ./output/StartupBenchmark [n, default 10000000]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MappedRBTree.h"
+#include "RBTree.h"
+using namespace std;
+
+template<class Function>
+double seconds(Function&& function){
+    auto start = chrono::steady_clock::now();
+    function();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+//keeps the lookups from being optimized away
+static size_t found = 0;
+
+template<class Tree>
+double firstLookups(const Tree& tree, const vector<int>& probes){
+    return seconds([&]{ for(int key : probes) found += tree.contains(key); });
+}
+
+void report(const string& what, double startup, double lookups){
+    cout << left << setw(20) << what << right << fixed << setprecision(3)
+         << setw(12) << startup * 1000 << " ms" << setw(14) << lookups * 1e6 << " us" << endl;
+}
+
+int main(int argc, char* argv[]){
+    size_t n = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 10000000;
+    string path = (filesystem::temp_directory_path() / "StartupBenchmark.rbt").string();
+
+    mt19937 random(12345);
+    vector<int> keys(n);
+    for(int& key : keys) key = static_cast<int>(random() >> 1);
+    vector<int> probes(1000);
+    for(int& key : probes) key = keys[random() % n];
+
+    cout << "n = " << n << endl;
+    cout << left << setw(20) << "startup" << right << setw(15) << "ready after" << setw(17) << "1000 lookups" << endl;
+
+    {
+        rb::RBSet<int> tree;
+        double startup = seconds([&]{ for(int key : keys) tree.insert(key); });
+        report("insert loop", startup, firstLookups(tree, probes));
+    }
+    {
+        rb::RBSet<int> tree;
+        double startup = seconds([&]{
+            vector<int> sorted = keys;
+            sort(sorted.begin(), sorted.end());
+            sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+            tree.assignSorted(sorted.begin(), sorted.end());
+        });
+        report("sort + bulk load", startup, firstLookups(tree, probes));
+
+        double saveTime = seconds([&]{ tree.save(path); });
+        cout << "(save " << fixed << setprecision(3) << saveTime * 1000 << " ms, "
+             << filesystem::file_size(path) / (1024.0 * 1024.0) << " MiB)" << endl;
+    }
+    {
+        rb::RBSet<int> tree;
+        double startup = seconds([&]{ tree.load(path); });
+        report("load()", startup, firstLookups(tree, probes));
+    }
+    {
+        double startup = 0;
+        {
+            auto start = chrono::steady_clock::now();
+            rb::MappedRBSet<int> mapped(path, true);
+            startup = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            report("mmap + checksum", startup, firstLookups(mapped, probes));
+        }
+        {
+            auto start = chrono::steady_clock::now();
+            rb::MappedRBSet<int> mapped(path, false);
+            startup = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            report("mmap", startup, firstLookups(mapped, probes));
+        }
+    }
+
+    remove(path.c_str());
+    return found == 42 ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+/*
+insertBatch and removeBatch of rb::RBTree against std::set / std::map
+
+every round fills a tree, then runs batches of a size picked around the switch between the two
+paths (batch * batchRebuildRatio >= size(): merge and rebuild, otherwise finger search):
+a few keys, just below, at and just above size() / batchRebuildRatio, and more than size().
+a batch is unsorted and mixes keys of the tree, missing keys and duplicates, now and then the
+first one comes right after a split() (size not counted yet). checked:
+    the returned count, isValidRBTree(), size() and the keys
+    maps: an inserted key gets the value of its first occurrence in the batch, a key already
+    in the tree keeps its value
+for the packed-pointer and index layouts, subtree sizes (with select()) and std::greater<int>.
+
+build: g++ -O2 -std=c++20 -I. test/BatchTest.c++ -o output/BatchTest
+       (or the CMake target BatchTest, which ctest runs)
+run:   ./output/BatchTest [seed, default 1] [rounds, default 300]
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "RBTree.h"
+using namespace std;
+
+template<class Tree>
+using Reference = map<int, int, typename Tree::key_compare>;
+
+template<class Tree>
+void same(const Tree& tree, const Reference<Tree>& reference, const string& what){
+    bool ok = test::check(tree.isValidRBTree(), what + ": red-black rules broken");
+    ok &= test::check(tree.size() == reference.size(), what + ": size() is " + to_string(tree.size()) + " instead of " + to_string(reference.size()));
+    if(!ok) return;
+
+    bool sameElements = true;
+    auto expected = reference.begin();
+    for(auto it = tree.begin(); sameElements && it != tree.end(); ++it, ++expected){
+        sameElements = it.key() == expected->first;
+        if constexpr (!Tree::isSet) sameElements &= it.value() == expected->second;
+    }
+    test::check(sameElements, what + ": elements differ from the reference");
+
+    //select() reads the subtree sizes, which the rebuild path sets from scratch
+    if constexpr (requires { tree.select(0); }){
+        size_t k = 0;
+        for(expected = reference.begin(); expected != reference.end(); ++expected, ++k){
+            if(!test::check(tree.select(k) == expected->first, what + ": select(" + to_string(k) + ")")) break;
+        }
+    }
+}
+
+//keys of the tree, missing keys and repeats, in random order
+vector<int> randomBatch(mt19937_64& rng, const vector<int>& present, size_t n, int keyRange){
+    vector<int> batch;
+    for(size_t i = 0; i < n; i++){
+        uint64_t roll = rng() % 10;
+        if(roll < 4 && !present.empty()) batch.push_back(present[rng() % present.size()]);
+        else if(roll < 5 && !batch.empty()) batch.push_back(batch[rng() % batch.size()]);
+        else batch.push_back(int(rng() % keyRange));
+    }
+    return batch;
+}
+
+template<class Tree>
+void runRound(const string& name, uint64_t seed, uint64_t round){
+    mt19937_64 rng(seed * 1000003 + round);
+    int keyRange = (rng() % 2) ? 200 : 100000;
+    size_t sizes[] = { 0, 1 + rng() % 20, 100 + rng() % 100, 2000 + rng() % 2000 };
+    size_t n = sizes[rng() % size(sizes)];
+    string where = name + " seed " + to_string(seed) + " round " + to_string(round);
+
+    Tree tree;
+    Reference<Tree> reference;
+    while(reference.size() < n && reference.size() < size_t(keyRange)){
+        int key = int(rng() % keyRange);
+        reference.emplace(key, key);
+        test::insertKey(tree, key, key);
+    }
+    same(tree, reference, where + " filled");
+
+    //split() on a shared pool leaves the size uncounted, the first batch has to count it itself
+    if(rng() % 4 == 0){
+        int splitKey = int(rng() % keyRange);
+        tree.split(splitKey);
+        reference.erase(reference.lower_bound(splitKey), reference.end());
+    }
+
+    for(int step = 0; step < 8; step++){
+        vector<int> present;
+        for(const auto& element : reference) present.push_back(element.first);
+
+        //around the threshold between the two paths
+        size_t threshold = reference.size() / Tree::batchRebuildRatio;
+        size_t batchSizes[] = { 1 + rng() % 8, threshold ? threshold - 1 : 0, threshold, threshold + 1, reference.size() + 1 + rng() % 100 };
+        size_t batchSize = batchSizes[rng() % size(batchSizes)];
+        vector<int> batch = randomBatch(rng, present, batchSize, keyRange);
+        string at = where + " step " + to_string(step) + " batch of " + to_string(batch.size()) + " on " + to_string(reference.size());
+
+        if(rng() % 2){
+            size_t expected = 0;
+            vector<decltype(test::elementOf<Tree>(0, 0))> elements;
+            for(size_t i = 0; i < batch.size(); i++){
+                //the value tells which occurrence of a key won
+                expected += reference.emplace(batch[i], int(i) + 1000000).second;
+                elements.push_back(test::elementOf<Tree>(batch[i], int(i) + 1000000));
+            }
+            if constexpr (Tree::isSet){
+                for(auto& element : reference) element.second = element.first;
+            }
+            size_t inserted = tree.insertBatch(elements.begin(), elements.end());
+            test::check(inserted == expected, at + ": insertBatch returned " + to_string(inserted) + " instead of " + to_string(expected));
+            same(tree, reference, at + " insertBatch");
+        }
+        else{
+            size_t expected = 0;
+            for(int key : batch) expected += reference.erase(key);
+            size_t removed = tree.removeBatch(batch.begin(), batch.end());
+            test::check(removed == expected, at + ": removeBatch returned " + to_string(removed) + " instead of " + to_string(expected));
+            same(tree, reference, at + " removeBatch");
+        }
+    }
+}
+
+template<class Tree>
+void randomRounds(const string& name, uint64_t seed, uint64_t rounds){
+    for(uint64_t round = 0; round < rounds; round++) runRound<Tree>(name, seed, round);
+}
+
+int main(int argc, char* argv[]){
+    uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1;
+    uint64_t rounds = argc > 2 ? strtoull(argv[2], nullptr, 10) : 300;
+
+    test::runTree("rb::RBSet", randomRounds<rb::RBSet<int>>, seed, rounds);
+    test::runTree("rb::RBSet IndexLayout", randomRounds<rb::RBSet<int, less<int>, rb::NodePool<int>, rb::IndexLayout>>, seed, rounds);
+    test::runTree("rb::RBSet std::greater", randomRounds<rb::RBSet<int, greater<int>>>, seed, rounds);
+    test::runTree("rb::OrderStatisticSet", randomRounds<rb::OrderStatisticSet<int>>, seed, rounds);
+    test::runTree("rb::RBMap", randomRounds<rb::RBMap<int, int>>, seed, rounds);
+    test::runTree("rb::RBMap IndexLayout", randomRounds<rb::RBMap<int, int, less<int>, rb::NodePool<int>, rb::IndexLayout>>, seed, rounds);
+    return test::finish("BatchTest");
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+failure reporting shared by the API tests in test/
+
+    check(condition, what)  prints "FAILED  what" and counts it when condition is false
+    keysOf(tree)            the keys of a tree in iteration order
+    finish(name)            prints the verdict, the exit code for main()
+
+and the fixtures of the tests on int keys, for sets (Tree::isSet) and maps alike:
+
+    insertKey(tree, key, value)     insert(key) on sets, emplace(key, value) on maps
+    elementOf<Tree>(key, value)     what insertBatch / assignSorted take: the key or a (key, value) pair
+    elementsOf(tree, valueOf)       the elements of a tree as a std::map, valueOf(key) the values of a set
+    runTree(name, scenario, args)   runs scenario(name, args...), prints "name: ok" or "name: FAILED"
+
+a test keeps going after a failure, so one run lists every broken case; the random cases
+print their seed and round in 'what' to be reproduced alone.
+*/
+
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace test {
+
+inline std::size_t& failures(){
+    static std::size_t count = 0;
+    return count;
+}
+
+inline bool check(bool condition, const std::string& what){
+    if(!condition){
+        //the first few are enough to debug, the count tells the rest
+        if(failures() < 20) std::cout << "FAILED  " << what << std::endl;
+        failures()++;
+    }
+    return condition;
+}
+
+template<class Tree>
+std::vector<typename Tree::key_type> keysOf(const Tree& tree){
+    std::vector<typename Tree::key_type> keys;
+    for(auto it = tree.begin(); it != tree.end(); ++it) keys.push_back(it.key());
+    return keys;
+}
+
+template<class Tree, class Value>
+bool insertKey(Tree& tree, int key, Value&& value){
+    if constexpr (Tree::isSet) return tree.insert(key);
+    else return tree.emplace(key, std::forward<Value>(value));
+}
+
+template<class Tree>
+std::conditional_t<Tree::isSet, int, std::pair<int, int>> elementOf(int key, int value){
+    if constexpr (Tree::isSet) return key;
+    else return { key, value };
+}
+
+template<class Tree, class ValueOf>
+auto elementsOf(const Tree& tree, ValueOf valueOf){
+    std::map<int, std::invoke_result_t<ValueOf, int>> elements;
+    if constexpr (Tree::isSet) tree.forEach([&](int key){ elements.emplace(key, valueOf(key)); });
+    else tree.forEach([&](int key, const auto& value){ elements.emplace(key, value); });
+    return elements;
+}
+
+template<class Scenario, class... Args>
+void runTree(const std::string& name, Scenario&& scenario, Args&&... args){
+    std::size_t before = failures();
+    scenario(name, std::forward<Args>(args)...);
+    std::cout << name << (failures() == before ? ": ok" : ": FAILED") << std::endl;
+}
+
+inline int finish(const std::string& name){
+    if(failures() == 0) std::cout << name << ": ok" << std::endl;
+    else std::cout << name << ": " << failures() << " checks FAILED" << std::endl;
+    return failures() == 0 ? 0 : 1;
+}
+
+}   //namespace test
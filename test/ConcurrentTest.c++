@@ -0,0 +1,174 @@
+/*
+rb::ConcurrentRBTree against std::set / std::map
+
+single thread   random insert / emplace / remove, every result against the reference, every
+                checkEvery operations contains, find, forEachInRange, size() and isValidRBTree()
+threads         one writer churns the odd keys while reader threads walk the tree. the even
+                keys are inserted before and never removed, keys >= keyRange never inserted, so
+                every read has a known answer:
+                    contains(even) true, find(even) its value, contains(missing) false
+                    forEachInRange(lo, hi) ascending, inside [lo, hi], with every even key of it
+                at the end the tree has to hold exactly what the writer's std::map says.
+for rb::ConcurrentRBSet and rb::ConcurrentRBMap with NodePool and std::allocator.
+
+build: g++ -O2 -std=c++20 -I. test/ConcurrentTest.c++ -o output/ConcurrentTest -pthread
+       (or the CMake target ConcurrentTest, which ctest runs)
+run:   ./output/ConcurrentTest [seed, default 1] [writer operations, default 100000] [readers, default 3]
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "ConcurrentRBTree.h"
+using namespace std;
+
+constexpr uint64_t checkEvery = 1000;
+constexpr int keyRange = 4096;
+
+//the keys of [lo, hi] in the order forEachInRange hands them out, values checked on the way
+template<class Tree>
+vector<int> keysIn(const Tree& tree, int lo, int hi, bool& valuesRight){
+    vector<int> keys;
+    valuesRight = true;
+    if constexpr (Tree::isSet) tree.forEachInRange(lo, hi, [&](int key){ keys.push_back(key); });
+    else tree.forEachInRange(lo, hi, [&](int key, int value){
+        keys.push_back(key);
+        valuesRight &= value == key * 2;
+    });
+    return keys;
+}
+
+template<class Tree>
+void checkAll(const Tree& tree, const map<int, int>& reference, const string& where){
+    test::check(tree.isValidRBTree(), where + ": red-black rules broken");
+    test::check(tree.size() == reference.size(), where + ": size() is " + to_string(tree.size()) + " instead of " + to_string(reference.size()));
+
+    bool valuesRight;
+    vector<int> keys = keysIn(tree, -1, keyRange, valuesRight), expected;
+    for(const auto& [key, value] : reference) expected.push_back(key);
+    test::check(keys == expected && valuesRight, where + ": forEachInRange differs from the reference");
+
+    for(int key = -1; key <= keyRange; key += 7){
+        bool present = reference.count(key) == 1;
+        test::check(tree.contains(key) == present, where + ": contains(" + to_string(key) + ")");
+        if constexpr (!Tree::isSet){
+            optional<int> value = tree.find(key);
+            test::check(present ? value == key * 2 : !value, where + ": find(" + to_string(key) + ")");
+        }
+    }
+}
+
+template<class Tree>
+void singleThread(const string& name, uint64_t seed, uint64_t operations){
+    Tree tree;
+    map<int, int> reference;
+    mt19937_64 rng(seed);
+
+    for(uint64_t i = 1; i <= operations; i++){
+        int key = int(rng() % keyRange);
+        if(rng() % 2) test::check(test::insertKey(tree, key, key * 2) == reference.emplace(key, key * 2).second, name + " insert(" + to_string(key) + ")");
+        else test::check(tree.remove(key) == (reference.erase(key) == 1), name + " remove(" + to_string(key) + ")");
+        if(i % checkEvery == 0) checkAll(tree, reference, name + " single thread, operation " + to_string(i));
+    }
+    checkAll(tree, reference, name + " single thread, end");
+}
+
+//what one reader saw go wrong, only counted in the thread and reported after join()
+struct ReaderErrors{
+    uint64_t missingStable = 0, foundMissing = 0, wrongValue = 0, badRange = 0, reads = 0;
+};
+
+template<class Tree>
+void reader(const Tree& tree, uint64_t seed, const atomic<bool>& done, ReaderErrors& errors){
+    mt19937_64 rng(seed);
+    while(!done.load(memory_order_acquire)){
+        int key = int(rng() % keyRange);
+        if(key % 2 == 0 && !tree.contains(key)) errors.missingStable++;
+        if(tree.contains(keyRange + key)) errors.foundMissing++;
+        if constexpr (!Tree::isSet){
+            if(key % 2 == 0 && tree.find(key) != key * 2) errors.wrongValue++;
+        }
+
+        int lo = int(rng() % keyRange), hi = lo + int(rng() % 256);
+        bool valuesRight;
+        vector<int> keys = keysIn(tree, lo, hi, valuesRight);
+        size_t evens = 0;
+        bool ordered = valuesRight;
+        for(size_t i = 0; i < keys.size(); i++){
+            ordered &= keys[i] >= lo && keys[i] <= hi && (i == 0 || keys[i - 1] < keys[i]);
+            evens += keys[i] % 2 == 0;
+        }
+        //the even keys of [lo, min(hi, keyRange - 1)]
+        int top = min(hi, keyRange - 1);
+        size_t expectedEvens = top < lo ? 0 : size_t(top / 2 - (lo + 1) / 2 + 1);
+        if(!ordered || evens != expectedEvens) errors.badRange++;
+        errors.reads++;
+    }
+}
+
+template<class Tree>
+void withReaders(const string& name, uint64_t seed, uint64_t operations, int readers){
+    Tree tree;
+    map<int, int> reference;
+    for(int key = 0; key < keyRange; key += 2){
+        test::insertKey(tree, key, key * 2);
+        reference.emplace(key, key * 2);
+    }
+
+    atomic<bool> done{ false };
+    vector<ReaderErrors> errors(readers);
+    vector<thread> threads;
+    for(int i = 0; i < readers; i++) threads.emplace_back([&, i]{ reader(tree, seed * 100 + i, done, errors[i]); });
+
+    //the writer: only odd keys, the even ones stay
+    mt19937_64 rng(seed);
+    bool writerRight = true;
+    for(uint64_t i = 0; i < operations; i++){
+        int key = int(rng() % keyRange) | 1;
+        if(rng() % 2) writerRight &= test::insertKey(tree, key, key * 2) == reference.emplace(key, key * 2).second;
+        else writerRight &= tree.remove(key) == (reference.erase(key) == 1);
+        //one core runs everything, let the readers in now and then
+        if(i % 64 == 0) this_thread::yield();
+    }
+    done.store(true, memory_order_release);
+    for(thread& t : threads) t.join();
+
+    string where = name + " " + to_string(readers) + " readers, seed " + to_string(seed);
+    test::check(writerRight, where + ": a write returned the wrong result");
+    for(int i = 0; i < readers; i++){
+        const ReaderErrors& e = errors[i];
+        string reader = where + ", reader " + to_string(i) + ": ";
+        test::check(e.missingStable == 0, reader + to_string(e.missingStable) + " stable keys missing");
+        test::check(e.foundMissing == 0, reader + to_string(e.foundMissing) + " keys found which were never inserted");
+        test::check(e.wrongValue == 0, reader + to_string(e.wrongValue) + " wrong values");
+        test::check(e.badRange == 0, reader + to_string(e.badRange) + " inconsistent forEachInRange");
+        test::check(e.reads > 0, reader + "never got to read");
+    }
+    checkAll(tree, reference, where + ", end");
+}
+
+template<class Tree>
+void singleThreadThenReaders(const string& name, uint64_t seed, uint64_t operations, int readers){
+    singleThread<Tree>(name, seed, operations);
+    withReaders<Tree>(name, seed, operations, readers);
+}
+
+int main(int argc, char* argv[]){
+    uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1;
+    uint64_t operations = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000;
+    int readers = argc > 3 ? atoi(argv[3]) : 3;
+
+    test::runTree("rb::ConcurrentRBSet", singleThreadThenReaders<rb::ConcurrentRBSet<int>>, seed, operations, readers);
+    test::runTree("rb::ConcurrentRBSet std::allocator", singleThreadThenReaders<rb::ConcurrentRBSet<int, less<int>, allocator<int>>>, seed, operations, readers);
+    test::runTree("rb::ConcurrentRBMap", singleThreadThenReaders<rb::ConcurrentRBMap<int, int>>, seed, operations, readers);
+    return test::finish("ConcurrentTest");
+}
@@ -0,0 +1,290 @@
+/*
+randomized differential test: every tree runs the same random operations as a std::set<int>
+
+trees      implement::RBTree (RBTreeImplement.c++), ai::RBTree (RBTreeAI.c++) and rb::RBTree
+           with the pointer, packed-pointer and index layouts, std::allocator and subtree sizes
+scenarios  random insert / remove / contains over a small key range (many duplicates and
+           misses, the tree empties and refills), a medium and a large one, ascending and
+           descending runs, and draining everything
+maps       rb::RBMap with both layouts against std::map, values emplaced from the tree itself,
+           and rb::RBMap<int, std::unique_ptr<int>> (pointer layouts, IndexLayout takes only trivially
+           copyable values): move-only values, emplace on a present key leaves its argument alone
+after every operation the result and contains(key) have to match std::set, every checkEvery
+operations (and at the end of a scenario) the whole tree is checked: isValidRBTree(), the keys
+in order, the size and the height bound 2 log2(n + 1).
+the first mismatch stops the tree with its seed, scenario and operation number, rerun with the
+same seed to reproduce it.
+
+build: g++ -O2 -std=c++20 -I. test/DifferentialTest.c++ RBTreeImplement.c++ RBTreeAI.c++ -o output/DifferentialTest
+       (or the CMake target DifferentialTest, which ctest runs)
+run:   ./output/DifferentialTest [seed, default 1] [operations per scenario, default 200000]
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "RBTree.h"
+#include "RBTreeAI.h"
+#include "RBTreeImplement.h"
+using namespace std;
+
+//the in-order keys, the original trees only have keys(), rb::RBTree has iterators
+vector<int> keysOf(const implement::RBTree& tree) { return tree.keys(); }
+vector<int> keysOf(const ai::RBTree& tree) { return tree.keys(); }
+template<class Tree>
+vector<int> keysOf(const Tree& tree) { return vector<int>(tree.begin(), tree.end()); }
+
+//the first mismatch, thrown out of the scenario
+struct Mismatch{
+    string what;
+};
+
+template<class Tree>
+class Checker{
+    private:
+        Tree tree_;
+        set<int> reference_;
+        string scenario_;
+        uint64_t operation_ = 0;
+
+        [[noreturn]] void fail(const string& what) const{
+            ostringstream message;
+            message << scenario_ << ", operation " << operation_ << ": " << what;
+            throw Mismatch{ message.str() };
+        }
+
+    public:
+        explicit Checker(const string& scenario) : scenario_(scenario) {}
+
+        void insert(int key){
+            operation_++;
+            bool inserted = reference_.insert(key).second;
+            if constexpr (is_same_v<decltype(tree_.insert(key)), bool>){
+                if(tree_.insert(key) != inserted) fail("insert(" + to_string(key) + ") returned " + (inserted ? "false" : "true"));
+            }
+            else tree_.insert(key);
+            if(!tree_.contains(key)) fail("key " + to_string(key) + " missing after insert");
+        }
+
+        void remove(int key){
+            operation_++;
+            bool removed = reference_.erase(key) == 1;
+            if constexpr (is_same_v<decltype(tree_.remove(key)), bool>){
+                if(tree_.remove(key) != removed) fail("remove(" + to_string(key) + ") returned " + (removed ? "false" : "true"));
+            }
+            else tree_.remove(key);
+            if(tree_.contains(key)) fail("key " + to_string(key) + " still there after remove");
+        }
+
+        void contains(int key){
+            operation_++;
+            if(tree_.contains(key) != (reference_.count(key) == 1)) fail("contains(" + to_string(key) + ") is wrong");
+        }
+
+        //O(n) check of the whole tree
+        void check() const{
+            if(!tree_.isValidRBTree()) fail("red-black rules broken");
+
+            vector<int> keys = keysOf(tree_);
+            if(keys.size() != reference_.size()) fail("holds " + to_string(keys.size()) + " keys instead of " + to_string(reference_.size()));
+            if(!equal(keys.begin(), keys.end(), reference_.begin())) fail("keys differ from std::set");
+            if constexpr (!is_same_v<Tree, implement::RBTree> && !is_same_v<Tree, ai::RBTree>){
+                if(tree_.size() != reference_.size()) fail("size() is " + to_string(tree_.size()));
+            }
+
+            double bound = 2 * log2(double(reference_.size()) + 1);
+            if(double(tree_.height()) > bound + 1e-9) fail("height " + to_string(tree_.height()) + " above 2 log2(n + 1)");
+        }
+
+        const set<int>& reference() const { return reference_; }
+};
+
+constexpr uint64_t checkEvery = 1000;
+
+//insertPercent inserts, removePercent removes, the rest lookups, keys in [0, keyRange)
+template<class Tree>
+void randomScenario(const string& name, uint64_t seed, uint64_t operations, int keyRange, int insertPercent, int removePercent){
+    Checker<Tree> checker(name);
+    mt19937_64 rng(seed);
+    uniform_int_distribution<int> keyOf(0, keyRange - 1);
+    uniform_int_distribution<int> percent(0, 99);
+
+    for(uint64_t i = 1; i <= operations; i++){
+        int roll = percent(rng);
+        int key = keyOf(rng);
+        if(roll < insertPercent) checker.insert(key);
+        else if(roll < insertPercent + removePercent) checker.remove(key);
+        else checker.contains(key);
+
+        if(i % checkEvery == 0) checker.check();
+    }
+    checker.check();
+
+    //drain in random order, the tree has to pass through every size down to empty
+    vector<int> keys(checker.reference().begin(), checker.reference().end());
+    shuffle(keys.begin(), keys.end(), rng);
+    for(size_t i = 0; i < keys.size(); i++){
+        checker.remove(keys[i]);
+        if(i % checkEvery == 0) checker.check();
+    }
+    checker.check();
+}
+
+//ascending inserts, then removes from both ends towards the middle
+template<class Tree>
+void sequentialScenario(uint64_t operations){
+    Checker<Tree> checker("sequential");
+    int n = int(operations / 2);
+
+    for(int key = 0; key < n; key++){
+        checker.insert(key);
+        if(key % int(checkEvery) == 0) checker.check();
+    }
+    checker.check();
+    for(int low = 0, high = n - 1; low <= high; low++, high--){
+        checker.remove(low);
+        if(low != high) checker.remove(high);
+        if(low % int(checkEvery) == 0) checker.check();
+    }
+    checker.check();
+
+    //descending inserts, ascending removes
+    for(int key = n - 1; key >= 0; key--) checker.insert(key);
+    checker.check();
+    for(int key = 0; key < n; key++){
+        checker.remove(key);
+        if(key % int(checkEvery) == 0) checker.check();
+    }
+    checker.check();
+}
+
+template<class Tree>
+bool runTree(const string& name, uint64_t seed, uint64_t operations){
+    try{
+        randomScenario<Tree>("small keys", seed, operations, 64, 45, 45);
+        randomScenario<Tree>("medium keys", seed + 1, operations, 4096, 50, 30);
+        randomScenario<Tree>("large keys", seed + 2, operations, 1 << 24, 60, 20);
+        sequentialScenario<Tree>(operations);
+    }
+    catch(const Mismatch& mismatch){
+        cout << left << setw(36) << name << "FAILED  seed " << seed << ", " << mismatch.what << endl;
+        return false;
+    }
+    cout << left << setw(36) << name << "ok" << endl;
+    return true;
+}
+
+/*
+maps against std::map<int, int>, the values included. new values are copied out of the tree
+itself (emplace(k, *find(j))), which reads from the node array while IndexLayout grows it
+*/
+template<class Map>
+bool runMap(const string& name, uint64_t seed, uint64_t operations){
+    Map tree;
+    map<int, int> reference;
+    mt19937_64 rng(seed);
+    uniform_int_distribution<int> keyOf(0, 4095);
+
+    for(uint64_t i = 1; i <= operations; i++){
+        int key = keyOf(rng), other = keyOf(rng);
+        bool ok = true;
+        if(rng() % 3 != 0){
+            auto found = tree.find(other);
+            int value = found != tree.end() ? found.value() : int(rng() % 1000);
+            bool inserted = reference.emplace(key, value).second;
+            ok = tree.emplace(key, found != tree.end() ? found.value() : value) == inserted;
+        }
+        else ok = tree.remove(key) == (reference.erase(key) == 1);
+
+        if(ok && i % checkEvery == 0){
+            ok = tree.isValidRBTree() && tree.size() == reference.size();
+            auto expected = reference.begin();
+            for(auto it = tree.begin(); ok && it != tree.end(); ++it, ++expected){
+                ok = it.key() == expected->first && it.value() == expected->second;
+            }
+        }
+        if(!ok){
+            cout << left << setw(36) << name << "FAILED  seed " << seed << ", operation " << i << endl;
+            return false;
+        }
+    }
+    cout << left << setw(36) << name << "ok" << endl;
+    return true;
+}
+
+/*
+maps of move-only values against std::map<int, int>: emplace(k, make_unique<int>(v)) moves the
+pointer in only when it inserts, a key already there leaves the argument untouched (what
+std::map::try_emplace promises). removes and finds in between, the pointed-to values compared
+*/
+template<class Map>
+bool runUniquePtrMap(const string& name, uint64_t seed, uint64_t operations){
+    Map tree;
+    map<int, int> reference;
+    mt19937_64 rng(seed);
+    uniform_int_distribution<int> keyOf(0, 1023);
+
+    for(uint64_t i = 1; i <= operations; i++){
+        int key = keyOf(rng);
+        bool ok = true;
+        uint64_t roll = rng() % 3;
+        if(roll == 0){
+            int value = int(rng() % 1000);
+            unique_ptr<int> pointer = make_unique<int>(value);
+            bool inserted = reference.emplace(key, value).second;
+            ok = tree.emplace(key, std::move(pointer)) == inserted && (inserted ? !pointer : pointer && *pointer == value);
+        }
+        else if(roll == 1) ok = tree.remove(key) == (reference.erase(key) == 1);
+        else{
+            auto found = tree.find(key);
+            auto expected = reference.find(key);
+            ok = expected == reference.end() ? found == tree.end() : found != tree.end() && found.value() && *found.value() == expected->second;
+        }
+
+        if(ok && i % checkEvery == 0){
+            ok = tree.isValidRBTree() && tree.size() == reference.size();
+            auto expected = reference.begin();
+            for(auto it = tree.begin(); ok && it != tree.end(); ++it, ++expected){
+                ok = it.key() == expected->first && it.value() && *it.value() == expected->second;
+            }
+        }
+        if(!ok){
+            cout << left << setw(36) << name << "FAILED  seed " << seed << ", operation " << i << endl;
+            return false;
+        }
+    }
+    cout << left << setw(36) << name << "ok" << endl;
+    return true;
+}
+
+int main(int argc, char* argv[]){
+    uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1;
+    uint64_t operations = argc > 2 ? strtoull(argv[2], nullptr, 10) : 200000;
+    cout << "seed " << seed << ", " << operations << " operations per scenario" << endl;
+
+    bool ok = true;
+    ok &= runTree<implement::RBTree>("implement::RBTree", seed, operations);
+    ok &= runTree<ai::RBTree>("ai::RBTree", seed, operations);
+    ok &= runTree<rb::RBSet<int>>("rb::RBSet", seed, operations);
+    ok &= runTree<rb::RBSet<int, less<int>, rb::NodePool<int>, rb::PointerLayout>>("rb::RBSet PointerLayout", seed, operations);
+    ok &= runTree<rb::RBSet<int, less<int>, rb::NodePool<int>, rb::IndexLayout>>("rb::RBSet IndexLayout", seed, operations);
+    ok &= runTree<rb::RBSet<int, less<int>, allocator<int>>>("rb::RBSet std::allocator", seed, operations);
+    ok &= runTree<rb::OrderStatisticSet<int>>("rb::OrderStatisticSet", seed, operations);
+    ok &= runMap<rb::RBMap<int, int>>("rb::RBMap", seed, operations);
+    ok &= runMap<rb::RBMap<int, int, less<int>, rb::NodePool<int>, rb::IndexLayout>>("rb::RBMap IndexLayout", seed, operations);
+    ok &= runUniquePtrMap<rb::RBMap<int, unique_ptr<int>>>("rb::RBMap unique_ptr", seed, operations);
+    ok &= runUniquePtrMap<rb::RBMap<int, unique_ptr<int>, less<int>, rb::NodePool<int>, rb::PointerLayout>>("rb::RBMap unique_ptr PointerLayout", seed, operations);
+    return ok ? 0 : 1;
+}
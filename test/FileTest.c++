@@ -0,0 +1,261 @@
+/*
+save(), load() and rb::MappedRBTree against std::map, and the rejection of damaged files
+
+round trips   random trees (empty, 1-20 keys, thousands) of every layout are saved, loaded into
+              an empty and into a filled tree, and mapped with and without the checksum pass;
+              both have to hold the saved elements (forEach, contains, find, forEachInRange,
+              select() after loading subtree sizes), and the loaded tree has to keep working
+damaged files every file below has to make load() throw std::runtime_error and leave the tree
+              as it was, and MappedRBTree either refuse to open it or report verify() false
+              and throw (never crash) on lookups:
+                  missing, empty, truncated header, truncated records, bad magic, other
+                  key / value types, a flipped record byte, and with a recomputed checksum:
+                  a link out of range, a cycle, keys out of order, a red root, unequal black heights
+
+build: g++ -O2 -std=c++20 -I. test/FileTest.c++ -o output/FileTest
+       (or the CMake target FileTest, which ctest runs)
+run:   ./output/FileTest [seed, default 1] [rounds, default 100] [directory for the files, default .]
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "MappedRBTree.h"
+#include "RBTree.h"
+using namespace std;
+
+vector<char> readFile(const string& path){
+    ifstream in(path, ios::binary);
+    return vector<char>(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void writeFile(const string& path, const vector<char>& bytes){
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(bytes.data(), streamsize(bytes.size()));
+}
+
+//maps hold key * 3 for every key, the elements of a set are compared with the same values
+int valueOf(int key) { return key * 3; }
+
+//lookups of the mapped tree against the saved elements
+template<class Mapped>
+void checkMapped(const Mapped& mapped, const map<int, int>& expected, mt19937_64& rng, const string& where){
+    test::check(mapped.size() == expected.size() && mapped.verify() && mapped.isValidRBTree(), where + ": size() or verify()");
+    test::check(test::elementsOf(mapped, valueOf) == expected, where + ": forEach differs");
+    for(int i = 0; i < 50; i++){
+        int key = int(rng() % 100002) - 1;
+        auto found = expected.find(key);
+        test::check(mapped.contains(key) == (found != expected.end()), where + ": contains(" + to_string(key) + ")");
+        if constexpr (!Mapped::isSet){
+            const int* value = mapped.find(key);
+            test::check(found == expected.end() ? !value : value && *value == found->second, where + ": find(" + to_string(key) + ")");
+        }
+
+        int hi = key + int(rng() % 5000);
+        vector<int> inRange, range;
+        if constexpr (Mapped::isSet) mapped.forEachInRange(key, hi, [&](int k){ inRange.push_back(k); });
+        else mapped.forEachInRange(key, hi, [&](int k, int){ inRange.push_back(k); });
+        for(auto it = expected.lower_bound(key); it != expected.end() && it->first <= hi; ++it) range.push_back(it->first);
+        test::check(inRange == range, where + ": forEachInRange(" + to_string(key) + ", " + to_string(hi) + ")");
+    }
+}
+
+template<class Tree>
+void roundTrip(const string& name, const string& path, uint64_t seed, uint64_t round){
+    mt19937_64 rng(seed * 1000003 + round);
+    size_t sizes[] = { 0, 1 + rng() % 20, 1 + rng() % 20, 1000 + rng() % 3000 };
+    size_t n = sizes[rng() % size(sizes)];
+    string where = name + " seed " + to_string(seed) + " round " + to_string(round);
+
+    //filled by inserts, then a split now and then: the saved tree may come out of any operation
+    Tree tree;
+    while(tree.size() < n){
+        int key = int(rng() % 100000);
+        test::insertKey(tree, key, valueOf(key));
+    }
+    if(rng() % 2) tree.split(int(rng() % 100000));
+    map<int, int> expected = test::elementsOf(tree, valueOf);
+    tree.save(path);
+
+    Tree loaded;
+    loaded.load(path);
+    test::check(loaded.isValidRBTree() && loaded.size() == expected.size() && test::elementsOf(loaded, valueOf) == expected, where + ": load() into an empty tree");
+    if constexpr (requires { loaded.select(0); }){
+        size_t k = 0;
+        for(auto it = expected.begin(); it != expected.end(); ++it, ++k){
+            if(!test::check(loaded.select(k) == it->first, where + ": select(" + to_string(k) + ") after load()")) break;
+        }
+    }
+
+    //load() replaces the content, and the loaded tree takes inserts and removes
+    Tree filled;
+    for(int key = 200000; key < 200100; key++) test::insertKey(filled, key, valueOf(key));
+    filled.load(path);
+    test::check(filled.isValidRBTree() && test::elementsOf(filled, valueOf) == expected, where + ": load() into a filled tree");
+    for(int i = 0; i < 200; i++){
+        int key = int(rng() % 100000);
+        if(rng() % 2){
+            test::insertKey(filled, key, valueOf(key));
+            expected.emplace(key, valueOf(key));
+        }
+        else{
+            filled.remove(key);
+            expected.erase(key);
+        }
+    }
+    test::check(filled.isValidRBTree() && filled.size() == expected.size() && test::elementsOf(filled, valueOf) == expected, where + ": updates after load()");
+
+    //empty files can't be mapped
+    if(tree.empty()) return;
+    expected = test::elementsOf(tree, valueOf);
+    using Mapped = rb::MappedRBTree<int, typename Tree::mapped_type>;
+    checkMapped(Mapped(path), expected, rng, where + " mapped");
+    checkMapped(Mapped(path, false), expected, rng, where + " mapped unverified");
+}
+
+//what has to happen to a damaged file: load() throws and keeps the tree, MappedRBTree refuses or reports it
+using Set = rb::RBSet<int>;
+using Record = rb::FileRecord<int, rb::Empty>;
+
+template<class Function>
+bool throwsRuntimeError(Function&& function){
+    try{
+        function();
+    }
+    catch(const runtime_error&){
+        return true;
+    }
+    return false;
+}
+
+void checkRejected(const string& path, const string& what, bool mappedOpens){
+    Set tree;
+    for(int key : { 5, 6, 7 }) tree.insert(key);
+    test::check(throwsRuntimeError([&]{ tree.load(path); }), what + ": load() did not throw");
+    test::check(tree.isValidRBTree() && test::elementsOf(tree, valueOf) == map<int, int>{ { 5, 15 }, { 6, 18 }, { 7, 21 } }, what + ": load() changed the tree");
+
+    using Mapped = rb::MappedRBSet<int>;
+    if(!mappedOpens){
+        test::check(throwsRuntimeError([&]{ Mapped mapped(path); }), what + ": MappedRBTree opened it");
+        return;
+    }
+    //the checksum is right, only the full check sees the damage; walks may throw but not crash
+    Mapped mapped(path);
+    test::check(!mapped.verify(), what + ": verify() passed");
+    for(int key = -1; key < 40; key++){
+        try{
+            mapped.contains(key);
+        }
+        catch(const runtime_error&) {}
+    }
+    try{
+        mapped.forEach([](int){});
+    }
+    catch(const runtime_error&) {}
+}
+
+//the file of a valid set, its records changed by edit, the checksum recomputed when asked
+void damagedFile(const vector<char>& original, const string& path, function<void(rb::FileHeader&, vector<Record>&)> edit, bool fixChecksum){
+    rb::FileHeader header;
+    memcpy(&header, original.data(), sizeof(header));
+    vector<Record> records(header.count);
+    memcpy(records.data(), original.data() + header.recordOffset, records.size() * sizeof(Record));
+
+    edit(header, records);
+    if(fixChecksum) header.checksum = rb::checksum(records.data(), records.size() * sizeof(Record));
+
+    vector<char> bytes(original.size());
+    memcpy(bytes.data(), &header, sizeof(header));
+    memcpy(bytes.data() + header.recordOffset, records.data(), records.size() * sizeof(Record));
+    writeFile(path, bytes);
+}
+
+void damagedFiles(const string& directory){
+    string good = directory + "/FileTest.good.rbt", bad = directory + "/FileTest.bad.rbt";
+    Set tree;
+    for(int key = 0; key < 31; key++) tree.insert(key);
+    tree.save(good);
+    vector<char> original = readFile(good);
+    rb::FileHeader header;
+    memcpy(&header, original.data(), sizeof(header));
+
+    remove(bad.c_str());
+    checkRejected(bad, "missing file", false);
+    writeFile(bad, {});
+    checkRejected(bad, "empty file", false);
+    writeFile(bad, vector<char>(original.begin(), original.begin() + 40));
+    checkRejected(bad, "truncated header", false);
+    writeFile(bad, vector<char>(original.begin(), original.end() - 1));
+    checkRejected(bad, "truncated records", false);
+
+    vector<char> bytes = original;
+    bytes[0] = 'X';
+    writeFile(bad, bytes);
+    checkRejected(bad, "bad magic", false);
+
+    damagedFile(original, bad, [](rb::FileHeader&, vector<Record>& records){ records[7].key ^= 1 << 20; }, false);
+    checkRejected(bad, "flipped record byte", false);
+
+    //a map file read as a set
+    rb::RBMap<int, int> other;
+    other.emplace(1, 2);
+    other.save(bad);
+    checkRejected(bad, "other key / value types", false);
+
+    //with a right checksum, only the shape, order and color checks can find these
+    damagedFile(original, bad, [](rb::FileHeader& h, vector<Record>& records){ records[h.root - 1].left = uint32_t(records.size() + 5); }, true);
+    checkRejected(bad, "link out of range", true);
+    damagedFile(original, bad, [](rb::FileHeader& h, vector<Record>& records){ records[0].left = h.root; }, true);
+    checkRejected(bad, "cycle", true);
+    damagedFile(original, bad, [](rb::FileHeader&, vector<Record>& records){ swap(records[3].key, records[4].key); }, true);
+    checkRejected(bad, "keys out of order", true);
+    damagedFile(original, bad, [](rb::FileHeader& h, vector<Record>& records){ records[h.root - 1].rightColor &= ~uint32_t(1); }, true);
+    checkRejected(bad, "red root", true);
+    //the leftmost leaf turns red, its path has one black node less than the others
+    damagedFile(original, bad, [](rb::FileHeader&, vector<Record>& records){
+        if(records[0].color() == rb::BLACK) records[0].rightColor &= ~uint32_t(1);
+        else records[0].rightColor |= 1;
+    }, true);
+    checkRejected(bad, "unequal black heights", true);
+
+    remove(good.c_str());
+    remove(bad.c_str());
+}
+
+template<class Tree>
+void roundTrips(const string& name, const string& directory, uint64_t seed, uint64_t rounds){
+    string path = directory + "/FileTest.rbt";
+    for(uint64_t round = 0; round < rounds; round++) roundTrip<Tree>(name, path, seed, round);
+    remove(path.c_str());
+}
+
+int main(int argc, char* argv[]){
+    uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1;
+    uint64_t rounds = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100;
+    string directory = argc > 3 ? argv[3] : ".";
+
+    test::runTree("rb::RBSet", roundTrips<rb::RBSet<int>>, directory, seed, rounds);
+    test::runTree("rb::RBSet IndexLayout", roundTrips<rb::RBSet<int, less<int>, rb::NodePool<int>, rb::IndexLayout>>, directory, seed, rounds);
+    test::runTree("rb::RBSet std::allocator", roundTrips<rb::RBSet<int, less<int>, allocator<int>>>, directory, seed, rounds);
+    test::runTree("rb::OrderStatisticSet", roundTrips<rb::OrderStatisticSet<int>>, directory, seed, rounds);
+    test::runTree("rb::RBMap", roundTrips<rb::RBMap<int, int>>, directory, seed, rounds);
+    test::runTree("rb::RBMap IndexLayout", roundTrips<rb::RBMap<int, int, less<int>, rb::NodePool<int>, rb::IndexLayout>>, directory, seed, rounds);
+
+    size_t before = test::failures();
+    damagedFiles(directory);
+    cout << "damaged files" << (test::failures() == before ? ": ok" : ": FAILED") << endl;
+    return test::finish("FileTest");
+}
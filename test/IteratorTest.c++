@@ -0,0 +1,184 @@
+/*
+iterators, bounds and range scans of rb::RBTree against std::set / std::map
+
+compile time   iterator, const_iterator and their reverse iterators of sets and maps model
+               std::bidirectional_iterator, the trees are std::ranges::bidirectional_range
+every round    a random tree (empty, a few keys or a few thousand), then
+                   ++ from begin(), -- from end(), rbegin() / rend(), views::reverse
+                   find, lower_bound, upper_bound, equal_range for keys below, inside and above
+                   forEach and forEachInRange(lo, hi)
+                   maps: values written through the iterator, ranges::find_if on the elements
+for the packed-pointer and index layouts.
+
+build: g++ -O2 -std=c++20 -I. test/IteratorTest.c++ -o output/IteratorTest
+       (or the CMake target IteratorTest, which ctest runs)
+run:   ./output/IteratorTest [seed, default 1] [rounds, default 500]
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <ranges>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Check.h"
+#include "RBTree.h"
+using namespace std;
+
+template<class Tree>
+constexpr bool iteratorsModelConcepts(){
+    static_assert(bidirectional_iterator<typename Tree::iterator>);
+    static_assert(bidirectional_iterator<typename Tree::const_iterator>);
+    static_assert(bidirectional_iterator<typename Tree::reverse_iterator>);
+    static_assert(bidirectional_iterator<typename Tree::const_reverse_iterator>);
+    static_assert(ranges::bidirectional_range<Tree> && ranges::common_range<Tree>);
+    static_assert(ranges::bidirectional_range<const Tree> && ranges::common_range<const Tree>);
+    return true;
+}
+static_assert(iteratorsModelConcepts<rb::RBSet<int>>());
+static_assert(iteratorsModelConcepts<rb::RBMap<int, int>>());
+static_assert(iteratorsModelConcepts<rb::RBSet<int, less<int>, rb::NodePool<int>, rb::IndexLayout>>());
+static_assert(iteratorsModelConcepts<rb::RBMap<int, int, less<int>, rb::NodePool<int>, rb::IndexLayout>>());
+static_assert(iteratorsModelConcepts<rb::OrderStatisticMap<int, int>>());
+
+vector<int> randomKeys(mt19937_64& rng, int keyRange){
+    size_t sizes[] = { 0, 1, 1 + rng() % 20, 1 + rng() % 20, 1000, 3000 };
+    size_t n = sizes[rng() % size(sizes)];
+    set<int> keys;
+    while(keys.size() < n && keys.size() < size_t(keyRange)) keys.insert(int(rng() % keyRange));
+    return vector<int>(keys.begin(), keys.end());
+}
+
+//it against the reference iterator: both at the end or at the same key
+template<class Tree, class It, class RefIt>
+bool sameSpot(const Tree& tree, It it, const vector<int>& keys, RefIt expected){
+    if(expected == keys.end()) return it == tree.end();
+    return it != tree.end() && it.key() == *expected;
+}
+
+//*it is the key for sets and a (key, value) pair for maps
+template<class Element>
+int keyOf(const Element& element){
+    if constexpr (is_same_v<Element, int>) return element;
+    else return element.first;
+}
+
+template<class Tree>
+void checkIteration(const Tree& tree, const vector<int>& keys, const string& where){
+    vector<int> forward, backward, reversed, viewed, scanned;
+    for(auto it = tree.begin(); it != tree.end(); ++it) forward.push_back(it.key());
+    for(auto it = tree.end(); it != tree.begin(); ) backward.push_back((--it).key());
+    for(auto it = tree.rbegin(); it != tree.rend(); ++it) reversed.push_back(keyOf(*it));
+    for(const auto& element : tree | views::reverse) viewed.push_back(keyOf(element));
+    if constexpr (Tree::isSet) tree.forEach([&](int key){ scanned.push_back(key); });
+    else tree.forEach([&](int key, int){ scanned.push_back(key); });
+
+    vector<int> descending(keys.rbegin(), keys.rend());
+    test::check(forward == keys, where + ": ++ from begin()");
+    test::check(backward == descending, where + ": -- from end()");
+    test::check(reversed == descending, where + ": rbegin() to rend()");
+    test::check(viewed == descending, where + ": views::reverse");
+    test::check(scanned == keys, where + ": forEach");
+    test::check(size_t(ranges::distance(tree)) == keys.size(), where + ": ranges::distance");
+}
+
+template<class Tree>
+void checkLookups(const Tree& tree, const vector<int>& keys, mt19937_64& rng, int keyRange, const string& where){
+    for(int i = 0; i < 200; i++){
+        int key = int(rng() % (keyRange + 2)) - 1;
+        if(!keys.empty() && i % 4 == 0) key = keys[rng() % keys.size()];
+        string at = where + " key " + to_string(key);
+
+        auto lower = lower_bound(keys.begin(), keys.end(), key), upper = upper_bound(keys.begin(), keys.end(), key);
+        bool present = lower != upper;
+        test::check(sameSpot(tree, tree.find(key), keys, present ? lower : keys.end()), at + ": find");
+        test::check(tree.contains(key) == present, at + ": contains");
+        test::check(sameSpot(tree, tree.lower_bound(key), keys, lower), at + ": lower_bound");
+        test::check(sameSpot(tree, tree.upper_bound(key), keys, upper), at + ": upper_bound");
+        auto [first, last] = tree.equal_range(key);
+        test::check(sameSpot(tree, first, keys, lower) && sameSpot(tree, last, keys, upper), at + ": equal_range");
+
+        //keys in [lo, hi], lo > hi included
+        int hi = int(rng() % (keyRange + 2)) - 1;
+        vector<int> inRange, expected;
+        if constexpr (Tree::isSet) tree.forEachInRange(key, hi, [&](int k){ inRange.push_back(k); });
+        else tree.forEachInRange(key, hi, [&](int k, int){ inRange.push_back(k); });
+        if(key <= hi) expected.assign(lower, upper_bound(keys.begin(), keys.end(), hi));
+        test::check(inRange == expected, at + ": forEachInRange(" + to_string(key) + ", " + to_string(hi) + ")");
+    }
+}
+
+//maps: writes through iterators against std::map, the const_iterator sees them
+template<class Tree>
+void checkMapValues(Tree& tree, const vector<int>& keys, mt19937_64& rng, const string& where){
+    map<int, int> reference;
+    for(int key : keys) reference.emplace(key, key);
+
+    for(auto it = tree.begin(); it != tree.end(); ++it){
+        int add = int(rng() % 100);
+        (*it).second += add;
+        reference[it.key()] += add;
+        if(rng() % 2){
+            it->second += 1;
+            reference[it.key()] += 1;
+        }
+    }
+    if(!keys.empty()){
+        int key = keys[rng() % keys.size()];
+        tree.find(key).value() = -1;
+        reference[key] = -1;
+    }
+
+    const Tree& constTree = tree;
+    bool same = size_t(distance(constTree.begin(), constTree.end())) == reference.size();
+    auto expected = reference.begin();
+    for(auto it = constTree.begin(); same && it != constTree.end(); ++it, ++expected){
+        same = it->first == expected->first && (*it).second == expected->second && it.value() == expected->second;
+    }
+    test::check(same, where + ": values written through iterators");
+
+    //ranges algorithms on the (key, value) elements, iterator -> const_iterator conversion
+    auto found = ranges::find_if(tree, [](const auto& element){ return element.second == -1; });
+    auto expectedFound = ranges::find_if(reference, [](const auto& element){ return element.second == -1; });
+    test::check((found == tree.end()) == (expectedFound == reference.end()) && (found == tree.end() || found.key() == expectedFound->first),
+                where + ": ranges::find_if");
+    typename Tree::const_iterator converted = found;
+    test::check(converted == constTree.find(found == tree.end() ? -2 : found.key()), where + ": iterator to const_iterator");
+}
+
+template<class Tree>
+void randomRounds(const string& name, uint64_t seed, uint64_t rounds){
+    for(uint64_t round = 0; round < rounds; round++){
+        mt19937_64 rng(seed * 1000003 + round);
+        int keyRange = (rng() % 2) ? 100 : 100000;
+        vector<int> keys = randomKeys(rng, keyRange);
+        string where = name + " seed " + to_string(seed) + " round " + to_string(round);
+
+        Tree tree;
+        vector<int> shuffled = keys;
+        shuffle(shuffled.begin(), shuffled.end(), rng);
+        for(int key : shuffled) test::insertKey(tree, key, key);
+
+        checkIteration(tree, keys, where);
+        checkLookups(tree, keys, rng, keyRange, where);
+        if constexpr (!Tree::isSet) checkMapValues(tree, keys, rng, where);
+    }
+}
+
+int main(int argc, char* argv[]){
+    uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1;
+    uint64_t rounds = argc > 2 ? strtoull(argv[2], nullptr, 10) : 500;
+
+    test::runTree("rb::RBSet", randomRounds<rb::RBSet<int>>, seed, rounds);
+    test::runTree("rb::RBSet IndexLayout", randomRounds<rb::RBSet<int, less<int>, rb::NodePool<int>, rb::IndexLayout>>, seed, rounds);
+    test::runTree("rb::RBMap", randomRounds<rb::RBMap<int, int>>, seed, rounds);
+    test::runTree("rb::RBMap IndexLayout", randomRounds<rb::RBMap<int, int, less<int>, rb::NodePool<int>, rb::IndexLayout>>, seed, rounds);
+    return test::finish("IteratorTest");
+}
@@ -0,0 +1,148 @@
+/*
+select(k), rank(key) and countRange(lo, hi) of the trees with subtree sizes against std::set
+
+random inserts and removes, now and then a whole-tree operation that has to keep the subtree
+sizes right (assignSorted, split + join, unionWith, differenceWith, insertBatch, removeBatch).
+every checkEvery operations:
+    select(k) for every k, select(size()) throws std::out_of_range
+    rank(key) and countRange(lo, hi) for random keys, missing ones and lo > hi included
+for rb::OrderStatisticSet with the packed-pointer, pointer and index layouts and rb::OrderStatisticMap.
+
+build: g++ -O2 -std=c++20 -I. test/OrderStatisticTest.c++ -o output/OrderStatisticTest
+       (or the CMake target OrderStatisticTest, which ctest runs)
+run:   ./output/OrderStatisticTest [seed, default 1] [operations, default 100000]
+*/
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "RBTree.h"
+using namespace std;
+
+constexpr uint64_t checkEvery = 500;
+
+template<class Tree>
+void checkQueries(const Tree& tree, const set<int>& reference, mt19937_64& rng, int keyRange, const string& where){
+    if(!test::check(tree.isValidRBTree() && tree.size() == reference.size(), where + ": tree broken or wrong size")) return;
+
+    size_t k = 0;
+    for(int key : reference){
+        if(!test::check(tree.select(k) == key, where + ": select(" + to_string(k) + ") is " + to_string(tree.select(k)) + " instead of " + to_string(key))) break;
+        k++;
+    }
+    bool thrown = false;
+    try{
+        tree.select(reference.size());
+    }
+    catch(const out_of_range&){
+        thrown = true;
+    }
+    test::check(thrown, where + ": select(size()) did not throw");
+
+    for(int i = 0; i < 100; i++){
+        int key = int(rng() % (keyRange + 2)) - 1;
+        size_t rank = size_t(distance(reference.begin(), reference.lower_bound(key)));
+        test::check(tree.rank(key) == rank, where + ": rank(" + to_string(key) + ") is " + to_string(tree.rank(key)) + " instead of " + to_string(rank));
+
+        int lo = int(rng() % (keyRange + 2)) - 1, hi = int(rng() % (keyRange + 2)) - 1;
+        size_t count = lo > hi ? 0 : size_t(distance(reference.lower_bound(lo), reference.upper_bound(hi)));
+        test::check(tree.countRange(lo, hi) == count,
+                    where + ": countRange(" + to_string(lo) + ", " + to_string(hi) + ") is " + to_string(tree.countRange(lo, hi)) + " instead of " + to_string(count));
+    }
+}
+
+//one of the whole-tree operations, applied to the tree and to the reference
+template<class Tree>
+void bulkOperation(Tree& tree, set<int>& reference, mt19937_64& rng, int keyRange){
+    vector<int> keys;
+    for(int i = int(rng() % 200); i > 0; i--) keys.push_back(int(rng() % keyRange));
+    //maps hold -key for every key
+    auto elementsOf = [](const auto& keys){
+        vector<decltype(test::elementOf<Tree>(0, 0))> elements;
+        for(int key : keys) elements.push_back(test::elementOf<Tree>(key, -key));
+        return elements;
+    };
+
+    switch(rng() % 6){
+        case 0: {
+            set<int> sorted(keys.begin(), keys.end());
+            auto elements = elementsOf(sorted);
+            tree.assignSorted(elements.begin(), elements.end());
+            reference = sorted;
+            break;
+        }
+        case 1: {
+            int splitKey = int(rng() % keyRange);
+            Tree upper = tree.split(splitKey);
+            size_t upperSize = size_t(distance(reference.lower_bound(splitKey), reference.end()));
+            test::check(upper.size() == upperSize && upper.isValidRBTree(), "split(" + to_string(splitKey) + ") upper half");
+            if(!upper.empty()) test::check(upper.select(0) == *reference.lower_bound(splitKey), "select(0) of the upper half");
+            tree.join(std::move(upper));
+            break;
+        }
+        case 2: {
+            Tree other;
+            for(int key : keys) test::insertKey(other, key, -key);
+            tree.unionWith(std::move(other));
+            reference.insert(keys.begin(), keys.end());
+            break;
+        }
+        case 3: {
+            Tree other;
+            for(int key : keys) test::insertKey(other, key, -key);
+            tree.differenceWith(other);
+            for(int key : keys) reference.erase(key);
+            break;
+        }
+        case 4: {
+            auto elements = elementsOf(keys);
+            tree.insertBatch(elements.begin(), elements.end());
+            reference.insert(keys.begin(), keys.end());
+            break;
+        }
+        default: {
+            tree.removeBatch(keys.begin(), keys.end());
+            for(int key : keys) reference.erase(key);
+            break;
+        }
+    }
+}
+
+template<class Tree>
+void randomOperations(const string& name, uint64_t seed, uint64_t operations){
+    mt19937_64 rng(seed);
+    Tree tree;
+    set<int> reference;
+
+    for(uint64_t i = 1; i <= operations; i++){
+        //the key range moves between small (dense, many duplicates) and large every 20000 operations
+        int keyRange = (i / 20000) % 2 ? 100000 : 2000;
+        int key = int(rng() % keyRange);
+        uint64_t roll = rng() % 1000;
+        if(roll < 3) bulkOperation(tree, reference, rng, keyRange);
+        else if(roll < 600) test::check(test::insertKey(tree, key, -key) == reference.insert(key).second, name + " insert(" + to_string(key) + ")");
+        else test::check(tree.remove(key) == (reference.erase(key) == 1), name + " remove(" + to_string(key) + ")");
+
+        if(i % checkEvery == 0) checkQueries(tree, reference, rng, keyRange, name + " seed " + to_string(seed) + " operation " + to_string(i));
+    }
+    checkQueries(tree, reference, rng, 100000, name + " seed " + to_string(seed) + " end");
+}
+
+int main(int argc, char* argv[]){
+    uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1;
+    uint64_t operations = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000;
+
+    test::runTree("rb::OrderStatisticSet", randomOperations<rb::OrderStatisticSet<int>>, seed, operations);
+    test::runTree("rb::OrderStatisticSet PointerLayout", randomOperations<rb::OrderStatisticSet<int, less<int>, rb::NodePool<int>, rb::PointerLayout>>, seed, operations);
+    test::runTree("rb::OrderStatisticSet IndexLayout", randomOperations<rb::OrderStatisticSet<int, less<int>, rb::NodePool<int>, rb::IndexLayout>>, seed, operations);
+    test::runTree("rb::OrderStatisticMap", randomOperations<rb::OrderStatisticMap<int, int>>, seed, operations);
+    return test::finish("OrderStatisticTest");
+}
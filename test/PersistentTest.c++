@@ -0,0 +1,184 @@
+/*
+rb::PersistentRBTree and its snapshots against std::set / std::map
+
+random insert / emplace / remove on the tree, every result against a std::map. now and then a
+snapshot is taken and kept together with a copy of the reference; snapshots are copied, moved
+and dropped at random. every checkEvery operations the tree and every kept snapshot have to
+match their reference: isValidRBTree(), size(), forEach, contains and find.
+a reader thread checks one snapshot over and over while the tree keeps changing.
+the nodes come from a counting allocator: once the tree and every snapshot are gone, no node
+may be left, and none may be freed twice.
+for rb::PersistentRBSet<int> and rb::PersistentRBMap<int, std::string>.
+
+build: g++ -O2 -std=c++20 -I. test/PersistentTest.c++ -o output/PersistentTest -pthread
+       (or the CMake target PersistentTest, which ctest runs)
+run:   ./output/PersistentTest [seed, default 1] [operations, default 50000]
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Check.h"
+#include "PersistentRBTree.h"
+using namespace std;
+
+constexpr uint64_t checkEvery = 1000;
+constexpr size_t maxSnapshots = 16;
+
+//std::allocator counting the objects alive, thread-safe like std::allocator itself
+inline atomic<long long> liveObjects{ 0 };
+
+template<class T>
+struct CountingAllocator{
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template<class U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n){
+        liveObjects.fetch_add((long long)n, memory_order_relaxed);
+        return allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n){
+        liveObjects.fetch_sub((long long)n, memory_order_relaxed);
+        allocator<T>().deallocate(p, n);
+    }
+
+    template<class U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+};
+
+using Set = rb::PersistentRBSet<int, less<int>, CountingAllocator<int>>;
+using Map = rb::PersistentRBMap<int, string, less<int>, CountingAllocator<int>>;
+
+string valueOf(int key, uint64_t operation) { return to_string(key) + "/" + to_string(operation); }
+
+template<class Version>
+bool same(const Version& version, const map<int, string>& reference){
+    if(!version.isValidRBTree() || version.size() != reference.size()) return false;
+
+    bool ok = true;
+    auto expected = reference.begin();
+    if constexpr (Version::isSet){
+        version.forEach([&](int key){ ok &= expected != reference.end() && key == (expected++)->first; });
+    }
+    else{
+        version.forEach([&](int key, const string& value){
+            ok &= expected != reference.end() && key == expected->first && value == expected->second;
+            ++expected;
+        });
+    }
+    return ok && expected == reference.end();
+}
+
+//lookups of random keys, a missing key included
+template<class Version>
+bool lookups(const Version& version, const map<int, string>& reference, mt19937_64& rng, int keyRange){
+    bool ok = true;
+    for(int i = 0; i < 20; i++){
+        int key = int(rng() % (keyRange + 1));
+        auto expected = reference.find(key);
+        ok &= version.contains(key) == (expected != reference.end());
+        if constexpr (!Version::isSet){
+            const string* value = version.find(key);
+            ok &= expected == reference.end() ? value == nullptr : value && *value == expected->second;
+        }
+    }
+    return ok;
+}
+
+template<class Tree>
+void randomOperations(const string& name, uint64_t seed, uint64_t operations){
+    {
+        Tree tree;
+        map<int, string> reference;
+        vector<pair<typename Tree::Snapshot, map<int, string>>> snapshots;
+        mt19937_64 rng(seed);
+
+        //a reader thread checks one snapshot until the writer is done
+        typename Tree::Snapshot shared = tree.snapshot();
+        map<int, string> sharedReference;
+        atomic<bool> done{ false };
+        atomic<uint64_t> readerErrors{ 0 }, readerRounds{ 0 };
+        thread reader;
+
+        for(uint64_t i = 1; i <= operations; i++){
+            int keyRange = (i / 10000) % 2 ? 100000 : 1000;
+            int key = int(rng() % keyRange);
+            string where = name + " seed " + to_string(seed) + " operation " + to_string(i);
+
+            uint64_t roll = rng() % 1000;
+            if(roll < 550){
+                string value = Tree::isSet ? string() : valueOf(key, i);
+                test::check(test::insertKey(tree, key, value) == reference.emplace(key, value).second, where + " insert");
+            }
+            else if(roll < 990) test::check(tree.remove(key) == (reference.erase(key) == 1), where + " remove");
+            else if(roll < 995 || snapshots.empty()){
+                if(snapshots.size() == maxSnapshots) snapshots.erase(snapshots.begin() + rng() % snapshots.size());
+                snapshots.emplace_back(tree.snapshot(), reference);
+            }
+            else{
+                //copy one snapshot over another, or move one out and drop it
+                size_t a = rng() % snapshots.size(), b = rng() % snapshots.size();
+                if(rng() % 2) snapshots[a] = snapshots[b];
+                else{
+                    typename Tree::Snapshot moved = std::move(snapshots[a].first);
+                    test::check(snapshots[a].first.empty() && same(moved, snapshots[a].second), where + " moved snapshot");
+                    snapshots.erase(snapshots.begin() + a);
+                }
+            }
+
+            if(i == operations / 2){
+                shared = tree.snapshot();
+                sharedReference = reference;
+                reader = thread([&]{
+                    mt19937_64 readerRng(seed + 1);
+                    while(!done.load(memory_order_acquire)){
+                        if(!same(shared, sharedReference) || !lookups(shared, sharedReference, readerRng, 100000)) readerErrors++;
+                        readerRounds++;
+                        this_thread::yield();
+                    }
+                });
+            }
+
+            if(i % checkEvery == 0){
+                test::check(same(tree, reference) && lookups(tree, reference, rng, keyRange), where + ": tree differs from std::map");
+                for(size_t s = 0; s < snapshots.size(); s++){
+                    test::check(same(snapshots[s].first, snapshots[s].second) && lookups(snapshots[s].first, snapshots[s].second, rng, keyRange),
+                                where + ": snapshot " + to_string(s) + " changed");
+                }
+            }
+        }
+
+        done.store(true, memory_order_release);
+        if(reader.joinable()) reader.join();
+        test::check(readerErrors == 0, name + ": the reader thread saw its snapshot change " + to_string(readerErrors) + " times");
+        test::check(operations < 2 || readerRounds > 0, name + ": the reader thread never ran");
+
+        //the tree changes, the snapshots don't
+        tree.clear();
+        test::check(tree.empty() && tree.isValidRBTree(), name + ": clear()");
+        for(auto& [snapshot, expected] : snapshots) test::check(same(snapshot, expected), name + ": snapshot after clear()");
+    }
+    test::check(liveObjects == 0, name + ": " + to_string(liveObjects) + " nodes left after every version was dropped");
+}
+
+int main(int argc, char* argv[]){
+    uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1;
+    uint64_t operations = argc > 2 ? strtoull(argv[2], nullptr, 10) : 50000;
+
+    test::runTree("rb::PersistentRBSet", randomOperations<Set>, seed, operations);
+    test::runTree("rb::PersistentRBMap", randomOperations<Map>, seed, operations);
+    return test::finish("PersistentTest");
+}
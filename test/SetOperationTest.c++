@@ -0,0 +1,184 @@
+/*
+bulk load, split, join and the set operations of rb::RBTree against std::set
+
+every round builds random trees (empty ones, 1-20 keys and a few thousand keys, filled by
+inserts in random order or by the bulk load) and checks the keys, size() and isValidRBTree()
+of every tree an operation leaves behind:
+    sortedUnique constructor and assignSorted
+    split(k) for k below, inside and above the keys, then join() of the two halves
+    move construction and assignment, the moved-from tree with a pool of its own
+    join() of trees with their own pools and of trees sharing one (get_allocator())
+    unionWith (moving and copying), intersectWith, differenceWith
+for the pointer, packed-pointer and index layouts, std::allocator and subtree sizes.
+
+build: g++ -O2 -std=c++20 -I. test/SetOperationTest.c++ -o output/SetOperationTest
+       (or the CMake target SetOperationTest, which ctest runs)
+run:   ./output/SetOperationTest [seed, default 1] [rounds, default 2000]
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Check.h"
+#include "RBTree.h"
+using namespace std;
+
+//random distinct keys, mostly small trees, now and then an empty one or a big one
+vector<int> randomKeys(mt19937_64& rng, int keyRange){
+    size_t sizes[] = { 0, 1 + rng() % 20, 1 + rng() % 20, 100, 1000, 3000 };
+    size_t n = sizes[rng() % size(sizes)];
+    set<int> keys;
+    while(keys.size() < n && keys.size() < size_t(keyRange)) keys.insert(int(rng() % keyRange));
+    return vector<int>(keys.begin(), keys.end());
+}
+
+template<class Tree>
+bool same(const Tree& tree, const vector<int>& expected, const string& what){
+    bool ok = test::check(tree.isValidRBTree(), what + ": red-black rules broken");
+    ok &= test::check(tree.size() == expected.size(), what + ": size() is " + to_string(tree.size()) + " instead of " + to_string(expected.size()));
+    ok &= test::check(test::keysOf(tree) == expected, what + ": keys differ from std::set");
+    return ok;
+}
+
+/*
+half of the trees come from inserts in random order, the other half from the bulk load:
+the two give differently shaped and colored trees
+*/
+template<class Tree>
+void build(Tree& tree, vector<int> keys, mt19937_64& rng){
+    if(rng() % 2){
+        tree.assignSorted(keys.begin(), keys.end());
+        return;
+    }
+    tree.clear();
+    shuffle(keys.begin(), keys.end(), rng);
+    for(int key : keys) tree.insert(key);
+}
+
+template<class Tree>
+void runRound(const string& name, uint64_t seed, uint64_t round){
+    mt19937_64 rng(seed * 1000003 + round);
+    int keyRange = (rng() % 2) ? 100 : 100000;
+    vector<int> a = randomKeys(rng, keyRange), b = randomKeys(rng, keyRange);
+    string where = name + " seed " + to_string(seed) + " round " + to_string(round);
+
+    //bulk load
+    Tree tree(rb::sortedUnique, a.begin(), a.end());
+    same(tree, a, where + " sortedUnique");
+    Tree assigned;
+    assigned.insert(-1);
+    assigned.assignSorted(b.begin(), b.end());
+    same(assigned, b, where + " assignSorted");
+
+    //split at a key below, between or above the keys, then join the halves back
+    build(tree, a, rng);
+    int splitKey = int(rng() % (keyRange + 2)) - 1;
+    if(!a.empty() && rng() % 2) splitKey = a[rng() % a.size()];
+    vector<int> left, right;
+    for(int key : a) (key < splitKey ? left : right).push_back(key);
+
+    Tree upper = tree.split(splitKey);
+    string splitWhere = where + " split(" + to_string(splitKey) + ")";
+    same(tree, left, splitWhere + " left");
+    same(upper, right, splitWhere + " right");
+    tree.join(std::move(upper));
+    same(tree, a, splitWhere + " join back");
+    same(upper, {}, splitWhere + " joined tree");
+
+    //the moved-from tree gets a pool of its own and stays usable
+    {
+        Tree moved(std::move(tree));
+        same(moved, a, where + " moved");
+        same(tree, {}, where + " moved-from");
+        if constexpr (is_pointer_v<typename Tree::Ref> && !allocator_traits<typename Tree::allocator_type>::is_always_equal::value){
+            test::check(tree.get_allocator() != moved.get_allocator(), where + " moved-from tree still shares the pool");
+        }
+        tree.insert(keyRange);
+        same(tree, { keyRange }, where + " moved-from insert");
+        tree = std::move(moved);
+        same(tree, a, where + " move assigned");
+    }
+
+    //join trees with separate pools and trees sharing one
+    {
+        Tree low, high;
+        build(low, left, rng);
+        build(high, right, rng);
+        low.join(std::move(high));
+        same(low, a, where + " join separate");
+    }
+    {
+        Tree low;
+        build(low, left, rng);
+        Tree high(std::less<int>(), low.get_allocator());
+        build(high, right, rng);
+        low.join(std::move(high));
+        same(low, a, where + " join shared");
+    }
+
+    //set operations
+    vector<int> expected;
+    set_union(a.begin(), a.end(), b.begin(), b.end(), back_inserter(expected));
+    {
+        Tree x, y;
+        build(x, a, rng);
+        build(y, b, rng);
+        x.unionWith(std::move(y));
+        same(x, expected, where + " unionWith(&&)");
+        same(y, {}, where + " unionWith(&&) other");
+    }
+    {
+        Tree x, y;
+        build(x, a, rng);
+        build(y, b, rng);
+        x.unionWith(y);
+        same(x, expected, where + " unionWith(const&)");
+        same(y, b, where + " unionWith(const&) other");
+    }
+
+    expected.clear();
+    set_intersection(a.begin(), a.end(), b.begin(), b.end(), back_inserter(expected));
+    {
+        Tree x, y;
+        build(x, a, rng);
+        build(y, b, rng);
+        x.intersectWith(y);
+        same(x, expected, where + " intersectWith");
+    }
+
+    expected.clear();
+    set_difference(a.begin(), a.end(), b.begin(), b.end(), back_inserter(expected));
+    {
+        Tree x, y;
+        build(x, a, rng);
+        build(y, b, rng);
+        x.differenceWith(y);
+        same(x, expected, where + " differenceWith");
+    }
+}
+
+template<class Tree>
+void randomRounds(const string& name, uint64_t seed, uint64_t rounds){
+    for(uint64_t round = 0; round < rounds; round++) runRound<Tree>(name, seed, round);
+}
+
+int main(int argc, char* argv[]){
+    uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1;
+    uint64_t rounds = argc > 2 ? strtoull(argv[2], nullptr, 10) : 2000;
+
+    test::runTree("rb::RBSet", randomRounds<rb::RBSet<int>>, seed, rounds);
+    test::runTree("rb::RBSet PointerLayout", randomRounds<rb::RBSet<int, less<int>, rb::NodePool<int>, rb::PointerLayout>>, seed, rounds);
+    test::runTree("rb::RBSet IndexLayout", randomRounds<rb::RBSet<int, less<int>, rb::NodePool<int>, rb::IndexLayout>>, seed, rounds);
+    test::runTree("rb::RBSet std::allocator", randomRounds<rb::RBSet<int, less<int>, allocator<int>>>, seed, rounds);
+    test::runTree("rb::OrderStatisticSet", randomRounds<rb::OrderStatisticSet<int>>, seed, rounds);
+    return test::finish("SetOperationTest");
+}